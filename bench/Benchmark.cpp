@@ -0,0 +1,437 @@
+#include <Fixture.hpp>
+#include "Results.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+
+using namespace std;
+using namespace eosio;
+
+// Action-level benchmark of the contract running on the in-memory chain from host/.
+// Every scenario starts from an empty chain; latency and operation counts are kept per "scenario/action".
+namespace {
+
+using host::fixture::SELF;
+using host::fixture::TOKEN_CONTRACT;
+using host::fixture::ISSUER;
+using host::fixture::FEE_COLLECTOR;
+using host::fixture::PAIR_FEE;
+using host::fixture::FEE_COLLECTOR_RATE;
+
+const uint64_t RANDOM_SEED = 20240501;
+const uint32_t BATCH_LEGS = 8;
+// liquidity added to every pair after create.pair, in initial pools
+const int64_t ADDED_POOLS = 3;
+
+struct Options {
+    bench::ReportOptions report;
+    uint32_t scale = 1;
+};
+
+// 3 letters from "index", for token, pair and user names
+string Letters(uint32_t index) {
+    string result(3, 'a');
+    for (int i = 2; i >= 0; i--) {
+        result[i] = char('a' + index % 26);
+        index /= 26;
+    }
+    return result;
+}
+
+symbol_code TokenCode(const uint32_t index) {
+    string code = "T" + Letters(index);
+    transform(code.begin(), code.end(), code.begin(), ::toupper);
+    return symbol_code { code };
+}
+
+symbol_code PairCode(const uint32_t index) {
+    string code = "LP" + Letters(index);
+    transform(code.begin(), code.end(), code.begin(), ::toupper);
+    return symbol_code { code };
+}
+
+name UserName(const uint32_t index) {
+    return name { "user" + Letters(index) };
+}
+
+extended_asset Token(const uint32_t index, const int64_t amount) {
+    return { asset { amount, symbol { TokenCode(index), 4 } }, TOKEN_CONTRACT };
+}
+
+class Benchmark {
+public:
+    // drops the chain and starts "scenario"
+    void Begin(const string& new_scenario) {
+        host::Chain::Get().Reset();
+        dex = make_unique<host::Dex>(SELF);
+        host::Chain::Get().AddAccount(ISSUER.value);
+        host::Chain::Get().AddAccount(FEE_COLLECTOR.value);
+        scenario = new_scenario;
+    }
+
+    template<typename Action>
+    bool Measure(const string& action_name, const vector<name>& auths, Action&& action) {
+        const auto start = chrono::steady_clock::now();
+        const bool success = dex->Run(auths, action);
+        const auto end = chrono::steady_clock::now();
+
+        Record(action_name, success, uint64_t(chrono::duration_cast<chrono::nanoseconds>(end - start).count()));
+        return success;
+    }
+
+    // "*::transfer" notification of a deposit to the contract
+    bool MeasureDeposit(const string& action_name, const name from, const extended_asset& quantity,
+                        const string& memo = "") {
+        const auto start = chrono::steady_clock::now();
+        const bool success = dex->Deposit(quantity.contract, from, quantity.quantity, memo);
+        const auto end = chrono::steady_clock::now();
+
+        Record(action_name, success, uint64_t(chrono::duration_cast<chrono::nanoseconds>(end - start).count()));
+        return success;
+    }
+
+    // deposits both pools to the issuer and creates the pair, only create.pair is measured; the issuer then adds
+    // ADDED_POOLS times the pools, as the initial supply is the min liquidity nothing could be swapped out otherwise
+    void CreatePair(const symbol_code code, const extended_asset& pool1, const extended_asset& pool2) {
+        AllowToken(pool1.get_extended_symbol());
+        AllowToken(pool2.get_extended_symbol());
+        MeasureDeposit("setup", ISSUER, pool1);
+        MeasureDeposit("setup", ISSUER, pool2);
+        Measure("create.pair", { SELF, ISSUER }, [&](Contract& contract) {
+            contract.CreatePair(ISSUER, code, pool1, pool2, PAIR_FEE, FEE_COLLECTOR, FEE_COLLECTOR_RATE);
+        });
+        host::fixture::AddLiquidity(*dex, ISSUER, { pool1.quantity * ADDED_POOLS, pool1.contract },
+                                    { pool2.quantity * ADDED_POOLS, pool2.contract }, symbol { code, 4 });
+    }
+
+    // deposits of tokens without a pair are rejected otherwise
+    void AllowToken(const extended_symbol token) {
+        Measure("setup", { SELF }, [&](Contract& contract) {
+            contract.AllowToken(token, true);
+        });
+    }
+
+    void AddUser(const name user) {
+        host::Chain::Get().AddAccount(user.value);
+    }
+
+    [[nodiscard]] host::Dex& GetDex() { return *dex; }
+    [[nodiscard]] const map<string, bench::Samples>& GetResults() const { return results; }
+
+private:
+    void Record(const string& action_name, const bool success, const uint64_t nanoseconds) {
+        if (action_name != "setup") {
+            bench::AddSample(results, scenario + "/" + action_name, success, nanoseconds);
+        }
+    }
+
+    unique_ptr<host::Dex> dex;
+    string scenario;
+    map<string, bench::Samples> results;
+};
+
+// pairs of fresh tokens
+void RunCreatePairs(Benchmark& benchmark, const Options& options) {
+    benchmark.Begin("pairs");
+
+    const uint32_t count = 64 * options.scale;
+    for (uint32_t i = 0; i < count; i++) {
+        benchmark.CreatePair(PairCode(i), Token(2 * i, 1000000000), Token(2 * i + 1, 2000000000));
+    }
+}
+
+// deposits of users without a deposit row, then with one, then withdrawals
+void RunColdWarmDeposits(Benchmark& benchmark, const Options& options) {
+    benchmark.Begin("deposits");
+
+    const uint32_t users = 500 * options.scale;
+    benchmark.AllowToken(Token(0, 0).get_extended_symbol());
+    for (uint32_t i = 0; i < users; i++) {
+        benchmark.AddUser(UserName(i));
+        benchmark.MeasureDeposit("transfer.cold", UserName(i), Token(0, 10000));
+    }
+    for (uint32_t i = 0; i < users; i++) {
+        benchmark.MeasureDeposit("transfer.warm", UserName(i), Token(0, 10000));
+    }
+    for (uint32_t i = 0; i < users; i++) {
+        const name user = UserName(i);
+        benchmark.Measure("withdraw", { user }, [&](Contract& contract) {
+            contract.Withdraw(user, Token(0, 0).get_extended_symbol());
+        });
+    }
+}
+
+// one user holding deposits of many tokens while swapping
+void RunManyDeposits(Benchmark& benchmark, const Options& options) {
+    benchmark.Begin("many.deposits");
+
+    const name user = UserName(0);
+    benchmark.AddUser(user);
+    benchmark.CreatePair(PairCode(0), Token(0, 1000000000), Token(1, 1000000000));
+
+    const uint32_t tokens = 256 * options.scale;
+    for (uint32_t i = 2; i < tokens; i++) {
+        benchmark.AllowToken(Token(i, 0).get_extended_symbol());
+        benchmark.MeasureDeposit("transfer", user, Token(i, 10000));
+    }
+    for (uint32_t i = 0; i < 100 * options.scale; i++) {
+        benchmark.MeasureDeposit("transfer", user, Token(0, 100000));
+        benchmark.Measure("swap", { user }, [&](Contract& contract) {
+            contract.Swap(user, symbol { PairCode(0), 4 }, Token(0, 100000), Token(1, 10000), {});
+        });
+    }
+    for (uint32_t i = 2; i < tokens; i++) {
+        benchmark.Measure("withdraw", { user }, [&](Contract& contract) {
+            contract.Withdraw(user, Token(i, 0).get_extended_symbol());
+        });
+    }
+}
+
+// pools at the limits of the initial amounts, one token is worth 10^9 of the other
+void RunExtremeReserves(Benchmark& benchmark, const Options& options) {
+    benchmark.Begin("extreme.reserves");
+
+    const name user = UserName(0);
+    const symbol pair_token { PairCode(0), 4 };
+    benchmark.AddUser(user);
+    benchmark.CreatePair(PairCode(0), Token(0, INIT_MAX - 1), Token(1, 1000000));
+
+    mt19937_64 random { RANDOM_SEED };
+    for (uint32_t i = 0; i < 500 * options.scale; i++) {
+        const int64_t in = uniform_int_distribution<int64_t> { 1000, 10000 }(random);
+        benchmark.MeasureDeposit("setup", user, Token(1, in));
+        benchmark.Measure("swap.in", { user }, [&](Contract& contract) {
+            contract.SwapIn(user, pair_token, Token(1, in), Token(0, 0), {});
+        });
+
+        // buys a few units of the expensive token for at most twice their price
+        const auto record = *benchmark.GetDex().GetPair(pair_token.code());
+        const int64_t out = uniform_int_distribution<int64_t> { 1, 10 }(random);
+        const int64_t max_in = record.pool1.quantity.amount / record.pool2.quantity.amount * out * 2;
+        benchmark.MeasureDeposit("setup", user, Token(0, max_in));
+        benchmark.Measure("swap", { user }, [&](Contract& contract) {
+            contract.Swap(user, pair_token, Token(0, max_in), Token(1, out), {});
+        });
+    }
+}
+
+// randomized swaps, liquidity changes and LP transfers of many users over a few pairs
+void RunRandomSequence(Benchmark& benchmark, const Options& options) {
+    benchmark.Begin("random");
+
+    const uint32_t tokens = 4;
+    const uint32_t users = 100;
+    vector<pair<symbol, pair<uint32_t, uint32_t>>> pairs;
+    for (uint32_t i = 0; i < tokens; i++) {
+        for (uint32_t j = i + 1; j < tokens; j++) {
+            const symbol_code code = PairCode(uint32_t(pairs.size()));
+            benchmark.CreatePair(code, Token(i, 10000000000), Token(j, 20000000000));
+            pairs.push_back({ symbol { code, 4 }, { i, j } });
+        }
+    }
+    for (uint32_t i = 0; i < users; i++) {
+        benchmark.AddUser(UserName(i));
+    }
+
+    mt19937_64 random { RANDOM_SEED };
+    uniform_int_distribution<uint32_t> pick_user { 0, users - 1 };
+    uniform_int_distribution<size_t> pick_pair { 0, pairs.size() - 1 };
+    uniform_int_distribution<uint32_t> pick_operation { 0, 9 };
+    uniform_int_distribution<int64_t> pick_share { 1, 1000 };    // of 10^5 of the pool
+
+    for (uint32_t step = 0; step < 5000 * options.scale; step++) {
+        const name user = UserName(pick_user(random));
+        const auto& [pair_token, tokens_of_pair] = pairs[pick_pair(random)];
+        const bool reversed = random() % 2 == 1;
+        const uint32_t token_in = reversed ? tokens_of_pair.second : tokens_of_pair.first;
+        const uint32_t token_out = reversed ? tokens_of_pair.first : tokens_of_pair.second;
+
+        const auto record = *benchmark.GetDex().GetPair(pair_token.code());
+        const extended_asset& pool_in = record.pool1.get_extended_symbol() == Token(token_in, 0).get_extended_symbol()
+            ? record.pool1 : record.pool2;
+        const extended_asset& pool_out = &pool_in == &record.pool1 ? record.pool2 : record.pool1;
+        const int64_t share = pick_share(random);
+
+        switch (pick_operation(random)) {
+            case 0: case 1: case 2: {
+                // exact out, the rest of the deposit is refunded
+                const int64_t out = max<int64_t>(1, pool_out.quantity.amount / 100000 * share);
+                const int64_t max_in = pool_in.quantity.amount / 100000 * share * 2 + 1;
+                benchmark.MeasureDeposit("transfer", user, Token(token_in, max_in));
+                benchmark.Measure("swap", { user }, [&](Contract& contract) {
+                    contract.Swap(user, pair_token, Token(token_in, max_in), Token(token_out, out), {});
+                });
+                break;
+            }
+            case 3: case 4: {
+                const int64_t in = max<int64_t>(1, pool_in.quantity.amount / 100000 * share);
+                benchmark.MeasureDeposit("transfer", user, Token(token_in, in));
+                benchmark.Measure("swap.in", { user }, [&](Contract& contract) {
+                    contract.SwapIn(user, pair_token, Token(token_in, in), Token(token_out, 0), {});
+                });
+                break;
+            }
+            case 5: {
+                const int64_t in = max<int64_t>(1, pool_in.quantity.amount / 100000 * share);
+                const string memo = "swap:" + pair_token.code().to_string() + ":0";
+                benchmark.MeasureDeposit("transfer.swap", user, Token(token_in, in), memo);
+                break;
+            }
+            case 6: case 7: {
+                // the add liquidity fee is paid on top of max_asset1 and max_asset2
+                const extended_asset asset1 { record.pool1.quantity * share / 100000, record.pool1.contract };
+                const extended_asset asset2 { record.pool2.quantity * share / 100000, record.pool2.contract };
+                const extended_asset max_asset1 {
+                    CalculateAmountWithoutFee(asset1.quantity.amount, ADD_LIQUIDITY_FEE), asset1.get_extended_symbol()
+                };
+                const extended_asset max_asset2 {
+                    CalculateAmountWithoutFee(asset2.quantity.amount, ADD_LIQUIDITY_FEE), asset2.get_extended_symbol()
+                };
+                benchmark.MeasureDeposit("transfer", user, asset1);
+                benchmark.MeasureDeposit("transfer", user, asset2);
+                benchmark.Measure("addliquidity", { user }, [&](Contract& contract) {
+                    contract.AddLiquidity(user, pair_token, max_asset1, max_asset2, {});
+                });
+                break;
+            }
+            case 8: {
+                const asset balance = benchmark.GetDex().GetBalance(user, record.supply.symbol);
+                if (balance.amount < 2) {
+                    break;
+                }
+                const extended_asset min1 { asset { 1, record.pool1.quantity.symbol }, record.pool1.contract };
+                const extended_asset min2 { asset { 1, record.pool2.quantity.symbol }, record.pool2.contract };
+                benchmark.Measure("remliquidity", { user }, [&](Contract& contract) {
+                    contract.RemoveLiquidity(user, asset { balance.amount / 2, balance.symbol }, min1, min2, {});
+                });
+                break;
+            }
+            default: {
+                const asset balance = benchmark.GetDex().GetBalance(user, record.supply.symbol);
+                const name to = UserName(pick_user(random));
+                if (balance.amount < 2 || to == user) {
+                    break;
+                }
+                benchmark.Measure("transfer.lp", { user }, [&](Contract& contract) {
+                    contract.Transfer(user, to, asset { balance.amount / 2, balance.symbol }, "");
+                });
+                break;
+            }
+        }
+    }
+}
+
+// the same BATCH_LEGS exact in swaps as separate swap.in actions and as one swap.batch; compare BATCH_LEGS times
+// "batch/swap.in" with "batch/swap.batch"
+void RunBatch(Benchmark& benchmark, const Options& options) {
+    benchmark.Begin("batch");
+
+    const uint32_t tokens = 4;
+    const name user = UserName(0);
+    vector<pair<symbol, pair<uint32_t, uint32_t>>> pairs;
+    for (uint32_t i = 0; i < tokens; i++) {
+        for (uint32_t j = i + 1; j < tokens; j++) {
+            const symbol_code code = PairCode(uint32_t(pairs.size()));
+            benchmark.CreatePair(code, Token(i, 10000000000), Token(j, 20000000000));
+            pairs.push_back({ symbol { code, 4 }, { i, j } });
+        }
+    }
+    benchmark.AddUser(user);
+
+    mt19937_64 random { RANDOM_SEED };
+    for (uint32_t round = 0; round < 100 * options.scale; round++) {
+        vector<Contract::SwapLeg> legs;
+        for (uint32_t i = 0; i < BATCH_LEGS; i++) {
+            const auto& [pair_token, tokens_of_pair] = pairs[random() % pairs.size()];
+            const bool reversed = random() % 2 == 1;
+            const uint32_t token_in = reversed ? tokens_of_pair.second : tokens_of_pair.first;
+            const uint32_t token_out = reversed ? tokens_of_pair.first : tokens_of_pair.second;
+            const int64_t in = uniform_int_distribution<int64_t> { 10000, 1000000 }(random);
+            legs.push_back({ pair_token, Token(token_in, in), Token(token_out, 0), true });
+        }
+
+        for (const Contract::SwapLeg& leg : legs) {
+            benchmark.MeasureDeposit("setup", user, leg.in);
+            benchmark.Measure("swap.in", { user }, [&](Contract& contract) {
+                contract.SwapIn(user, leg.pair_token, leg.in, leg.out, {});
+            });
+        }
+
+        for (const Contract::SwapLeg& leg : legs) {
+            benchmark.MeasureDeposit("setup", user, leg.in);
+        }
+        benchmark.Measure("swap.batch", { user }, [&](Contract& contract) {
+            contract.SwapBatch(user, legs);
+        });
+    }
+}
+
+// best route search over a complete graph of pairs with uneven prices
+void RunRoutes(Benchmark& benchmark, const Options& options) {
+    benchmark.Begin("routes");
+
+    const uint32_t tokens = 8;
+    uint32_t pair_index = 0;
+    for (uint32_t i = 0; i < tokens; i++) {
+        for (uint32_t j = i + 1; j < tokens; j++) {
+            benchmark.CreatePair(PairCode(pair_index++), Token(i, 10000000000 + int64_t(j) * 700000000),
+                                 Token(j, 10000000000 + int64_t(i) * 900000000));
+        }
+    }
+
+    mt19937_64 random { RANDOM_SEED };
+    for (uint32_t step = 0; step < 200 * options.scale; step++) {
+        const uint32_t token_in = uint32_t(random() % tokens);
+        const uint32_t token_out = (token_in + 1 + uint32_t(random() % (tokens - 1))) % tokens;
+        const uint8_t max_hops = uint8_t(1 + random() % 3);
+
+        benchmark.Measure("quote.route", {}, [&](Contract& contract) {
+            contract.QuoteRoute(Token(token_in, 100000000), Token(token_out, 0).get_extended_symbol(), max_hops);
+        });
+    }
+}
+
+bool ParseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const string argument = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (bench::ParseReportOption(argc, argv, i, options.report)) {
+            continue;
+        }
+        if (argument == "--scale" && has_value) {
+            options.scale = max(1, stoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        cerr << "usage: dex-bench " << bench::REPORT_USAGE << " [--scale <n>]" << endl;
+        return 2;
+    }
+
+#ifndef DEX_INSTRUMENTATION
+    cerr << "built without DEX_INSTRUMENTATION, operation counts are zero" << endl;
+#endif
+
+    Benchmark benchmark;
+    RunCreatePairs(benchmark, options);
+    RunColdWarmDeposits(benchmark, options);
+    RunManyDeposits(benchmark, options);
+    RunExtremeReserves(benchmark, options);
+    RunRandomSequence(benchmark, options);
+    RunRoutes(benchmark, options);
+    RunBatch(benchmark, options);
+
+    return bench::Report(benchmark.GetResults(), options.report, "dex-bench");
+}
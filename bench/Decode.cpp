@@ -0,0 +1,147 @@
+#include <Decoder.hpp>
+#include "Snapshot.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace eosio;
+
+// Decodes the pair, balance and deposit rows of the contract from a delta file or a table snapshot and writes them
+// to a column file. The delta file is mapped and decoded in place.
+namespace {
+
+struct Options {
+    string deltas;
+    string snapshot;
+    string output;
+    name self = "agora.dex"_n;
+};
+
+bool ParseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const string argument = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (argument == "--deltas" && has_value) {
+            options.deltas = argv[++i];
+        } else if (argument == "--snapshot" && has_value) {
+            options.snapshot = argv[++i];
+        } else if (argument == "--contract" && has_value) {
+            options.self = name { argv[++i] };
+        } else if (argument[0] != '-' && options.output.empty()) {
+            options.output = argument;
+        } else {
+            return false;
+        }
+    }
+    return !options.output.empty() && options.deltas.empty() != options.snapshot.empty();
+}
+
+// read only mapping of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const string& path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info {};
+        if (fstat(fd, &info) == 0) {
+            size = size_t(info.st_size);
+            valid = size == 0;
+        }
+        if (size > 0) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char*>(mapped);
+                valid = true;
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data != nullptr) {
+            munmap(const_cast<char*>(data), size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool valid = false;
+};
+
+bool Decode(const Options& options, host::TableDecoder& decoder, uint64_t& bytes) {
+    try {
+        if (!options.deltas.empty()) {
+            const MappedFile file { options.deltas };
+            if (!file.valid) {
+                cerr << "cannot read " << options.deltas << endl;
+                return false;
+            }
+            decoder.DecodeDeltaFile(file.data, file.size);
+            bytes = file.size;
+            return true;
+        }
+
+        vector<host::SnapshotRow> rows;
+        string error;
+        if (!bench::ReadSnapshot(options.snapshot, rows, error)) {
+            cerr << "snapshot: " << error << endl;
+            return false;
+        }
+        for (const host::SnapshotRow& row : rows) {
+            decoder.DecodeRow(row.table, row.scope, true, row.data.data(), row.data.size());
+            bytes += row.data.size();
+        }
+        return true;
+    } catch (const exception& e) {
+        cerr << "decode: " << e.what() << endl;
+        return false;
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        cerr << "usage: dex-decode <output> (--deltas <file> | --snapshot <file>) [--contract <name>]" << endl;
+        return 2;
+    }
+
+    host::TableDecoder decoder { options.self };
+    uint64_t bytes = 0;
+
+    const auto start = chrono::steady_clock::now();
+    if (!Decode(options, decoder, bytes)) {
+        return 2;
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (!decoder.WriteColumns(options.output)) {
+        cerr << "cannot write " << options.output << endl;
+        return 2;
+    }
+
+    printf("decoded %llu rows (%zu stat, %zu accounts, %zu deposits), skipped %llu\n",
+           (unsigned long long) decoder.GetDecoded(), decoder.GetPairs().scope.size(),
+           decoder.GetBalances().scope.size(), decoder.GetDeposits().scope.size(),
+           (unsigned long long) decoder.GetSkipped());
+    if (seconds > 0) {
+        printf("%.3f s, %.0f rows/s, %.1f MB/s\n", seconds, double(decoder.GetDecoded()) / seconds,
+               double(bytes) / seconds / 1e6);
+    }
+    return 0;
+}
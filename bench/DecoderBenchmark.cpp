@@ -0,0 +1,148 @@
+#include <Decoder.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace eosio;
+
+// Times host::TableDecoder on a synthetic delta file with millions of rows: 5% "stat", 45% "accounts",
+// 45% "depositsv2" and 5% rows of another contract, in blocks of ROWS_PER_BLOCK rows.
+namespace {
+
+const uint64_t DEFAULT_ROWS = 3000000;
+const uint32_t ROWS_PER_BLOCK = 1000;
+const uint64_t RANDOM_SEED = 20240501;
+
+const name SELF = "agora.dex"_n;
+const name OTHER = "other.dex"_n;
+
+class Writer {
+public:
+    void Byte(const uint8_t value) { data.push_back(char(value)); }
+
+    void UInt32(const uint32_t value) { Raw(&value, sizeof(value)); }
+
+    void UInt64(const uint64_t value) { Raw(&value, sizeof(value)); }
+
+    void VarUInt32(uint32_t value) {
+        do {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            if (value != 0) {
+                byte |= 0x80;
+            }
+            Byte(byte);
+        } while (value != 0);
+    }
+
+    void Bytes(const char* value, const size_t size) {
+        VarUInt32(uint32_t(size));
+        Raw(value, size);
+    }
+
+    void Raw(const void* value, const size_t size) {
+        const char* bytes = static_cast<const char*>(value);
+        data.insert(data.end(), bytes, bytes + size);
+    }
+
+    vector<char> data;
+};
+
+// contract_row_v0 as nested in table_delta rows
+vector<char> ContractRow(const name code, const uint64_t scope, const name table, const uint64_t primary_key,
+                         const vector<char>& value) {
+    Writer row;
+    row.VarUInt32(0);
+    row.UInt64(code.value);
+    row.UInt64(scope);
+    row.UInt64(table.value);
+    row.UInt64(primary_key);
+    row.UInt64(code.value);
+    row.Bytes(value.data(), value.size());
+    return row.data;
+}
+
+vector<char> MakeDeltaFile(const uint64_t rows) {
+    mt19937_64 random { RANDOM_SEED };
+    const symbol token { symbol_code { "TKN" }, 4 };
+    const extended_symbol token1 { symbol { symbol_code { "AAA" }, 4 }, "token.a"_n };
+    const extended_symbol token2 { symbol { symbol_code { "BBB" }, 8 }, "token.b"_n };
+
+    Writer file;
+    for (uint64_t begin = 0; begin < rows; begin += ROWS_PER_BLOCK) {
+        const uint32_t count = uint32_t(min<uint64_t>(ROWS_PER_BLOCK, rows - begin));
+
+        Writer block;
+        block.VarUInt32(1);
+        block.VarUInt32(0);
+        block.Bytes("contract_row", strlen("contract_row"));
+        block.VarUInt32(count);
+        for (uint32_t i = 0; i < count; i++) {
+            const uint64_t user = random();
+            const int64_t amount = int64_t(random() % 1000000000000);
+            const uint32_t kind = uint32_t(random() % 20);
+
+            vector<char> row;
+            if (kind == 0) {
+                const symbol pair_token { symbol_code { "LP" + string(1, char('A' + random() % 26)) }, 4 };
+                row = ContractRow(SELF, pair_token.code().raw(), "stat"_n, pair_token.code().raw(),
+                                  host::TableDecoder::EncodePair(asset { amount, pair_token },
+                                                                 extended_asset { amount, token1 },
+                                                                 extended_asset { amount * 3, token2 }, amount,
+                                                                 amount * 3, 30));
+            } else if (kind <= 9) {
+                row = ContractRow(SELF, user, "accounts"_n, token.code().raw(),
+                                  host::TableDecoder::EncodeBalance(asset { amount, token }));
+            } else if (kind <= 18) {
+                row = ContractRow(SELF, user, "depositsv2"_n, random(),
+                                  host::TableDecoder::EncodeDeposit(random(), extended_asset { amount, token1 }));
+            } else {
+                row = ContractRow(OTHER, user, "accounts"_n, token.code().raw(),
+                                  host::TableDecoder::EncodeBalance(asset { amount, token }));
+            }
+            block.Byte(1);
+            block.Bytes(row.data(), row.size());
+        }
+
+        file.UInt32(uint32_t(block.data.size()));
+        file.Raw(block.data.data(), block.data.size());
+    }
+    return file.data;
+}
+
+}
+
+int main(int argc, char** argv) {
+    uint64_t rows = DEFAULT_ROWS;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--rows" && i + 1 < argc) {
+            rows = stoull(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: dex-decode-bench [--rows <n>]\n");
+            return 2;
+        }
+    }
+
+    const vector<char> file = MakeDeltaFile(rows);
+    printf("fixture: %llu rows, %.1f MB\n", (unsigned long long) rows, double(file.size()) / 1e6);
+
+    host::TableDecoder decoder { SELF };
+    const auto start = chrono::steady_clock::now();
+    decoder.DecodeDeltaFile(file.data(), file.size());
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (decoder.GetDecoded() + decoder.GetSkipped() != rows) {
+        printf("decoded %llu and skipped %llu of %llu rows\n", (unsigned long long) decoder.GetDecoded(),
+               (unsigned long long) decoder.GetSkipped(), (unsigned long long) rows);
+        return 1;
+    }
+    printf("decoded %llu rows, skipped %llu\n", (unsigned long long) decoder.GetDecoded(),
+           (unsigned long long) decoder.GetSkipped());
+    printf("%.3f s, %.1f ns/row, %.0f rows/s, %.1f MB/s\n", seconds, seconds * 1e9 / double(rows),
+           double(rows) / seconds, double(file.size()) / seconds / 1e6);
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include "Json.hpp"
+
+#include <cctype>
+#include <charconv>
+
+using namespace std;
+
+namespace bench {
+
+class Json::Parser {
+public:
+    explicit Parser(const string_view text) : text(text) {}
+
+    Json ParseDocument() {
+        Json value = ParseValue();
+        SkipSpaces();
+        if (position != text.size()) {
+            Fail("trailing characters");
+        }
+        return value;
+    }
+
+private:
+    Json ParseValue() {
+        SkipSpaces();
+        if (position == text.size()) {
+            Fail("unexpected end");
+        }
+
+        Json value;
+        const char c = text[position];
+        if (c == '{') {
+            value.type = Type::Object;
+            position++;
+            SkipSpaces();
+            if (Consume('}')) {
+                return value;
+            }
+            do {
+                SkipSpaces();
+                string key = ParseString();
+                SkipSpaces();
+                Expect(':');
+                value.members.emplace_back(move(key), ParseValue());
+                SkipSpaces();
+            } while (Consume(','));
+            Expect('}');
+        } else if (c == '[') {
+            value.type = Type::Array;
+            position++;
+            SkipSpaces();
+            if (Consume(']')) {
+                return value;
+            }
+            do {
+                value.items.push_back(ParseValue());
+                SkipSpaces();
+            } while (Consume(','));
+            Expect(']');
+        } else if (c == '"') {
+            value.type = Type::String;
+            value.text = ParseString();
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            value.type = Type::Number;
+            const size_t begin = position;
+            while (position < text.size() && (isdigit(text[position]) || text[position] == '-'
+                   || text[position] == '+' || text[position] == '.' || text[position] == 'e'
+                   || text[position] == 'E')) {
+                position++;
+            }
+            value.text = text.substr(begin, position - begin);
+        } else if (ConsumeWord("true")) {
+            value.type = Type::Bool;
+            value.boolean = true;
+        } else if (ConsumeWord("false")) {
+            value.type = Type::Bool;
+        } else if (!ConsumeWord("null")) {
+            Fail("unexpected character");
+        }
+        return value;
+    }
+
+    string ParseString() {
+        Expect('"');
+        string result;
+        while (true) {
+            if (position == text.size()) {
+                Fail("unterminated string");
+            }
+            const char c = text[position++];
+            if (c == '"') {
+                return result;
+            }
+            if (c != '\\') {
+                result.push_back(c);
+                continue;
+            }
+            if (position == text.size()) {
+                Fail("unterminated string");
+            }
+            const char escaped = text[position++];
+            switch (escaped) {
+                case 'b': result.push_back('\b'); break;
+                case 'f': result.push_back('\f'); break;
+                case 'n': result.push_back('\n'); break;
+                case 'r': result.push_back('\r'); break;
+                case 't': result.push_back('\t'); break;
+                case 'u': AppendCodePoint(result); break;
+                default: result.push_back(escaped); break;
+            }
+        }
+    }
+
+    // \uXXXX as UTF-8, surrogate pairs are not combined
+    void AppendCodePoint(string& result) {
+        if (text.size() - position < 4) {
+            Fail("invalid escape");
+        }
+        uint32_t code = 0;
+        const auto [end, error] = from_chars(text.data() + position, text.data() + position + 4, code, 16);
+        if (error != errc() || end != text.data() + position + 4) {
+            Fail("invalid escape");
+        }
+        position += 4;
+
+        if (code < 0x80) {
+            result.push_back(char(code));
+        } else if (code < 0x800) {
+            result.push_back(char(0xC0 | (code >> 6)));
+            result.push_back(char(0x80 | (code & 0x3F)));
+        } else {
+            result.push_back(char(0xE0 | (code >> 12)));
+            result.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+            result.push_back(char(0x80 | (code & 0x3F)));
+        }
+    }
+
+    void SkipSpaces() {
+        while (position < text.size() && isspace(static_cast<unsigned char>(text[position]))) {
+            position++;
+        }
+    }
+
+    bool Consume(const char c) {
+        if (position < text.size() && text[position] == c) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ConsumeWord(const string_view word) {
+        if (text.substr(position, word.size()) == word) {
+            position += word.size();
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(const char c) {
+        if (!Consume(c)) {
+            Fail(string("expected '") + c + "'");
+        }
+    }
+
+    [[noreturn]] void Fail(const string& message) const {
+        throw JsonError(message + " at " + to_string(position));
+    }
+
+    string_view text;
+    size_t position = 0;
+};
+
+Json Json::Parse(const string_view text) {
+    return Parser(text).ParseDocument();
+}
+
+bool Json::GetBool() const {
+    if (type != Type::Bool) {
+        throw JsonError("not a boolean");
+    }
+    return boolean;
+}
+
+int64_t Json::GetInt() const {
+    int64_t value = 0;
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (type != Type::Number || error != errc() || end != text.data() + text.size()) {
+        throw JsonError("not an integer: " + text);
+    }
+    return value;
+}
+
+uint64_t Json::GetUInt() const {
+    uint64_t value = 0;
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (type != Type::Number || error != errc() || end != text.data() + text.size()) {
+        throw JsonError("not an unsigned integer: " + text);
+    }
+    return value;
+}
+
+const string& Json::GetString() const {
+    if (type != Type::String) {
+        throw JsonError("not a string");
+    }
+    return text;
+}
+
+const vector<Json>& Json::GetItems() const {
+    if (type != Type::Array) {
+        throw JsonError("not an array");
+    }
+    return items;
+}
+
+const Json* Json::Find(const string_view key) const {
+    if (type != Type::Object) {
+        throw JsonError("not an object");
+    }
+    for (const auto& [member_key, value] : members) {
+        if (member_key == key) {
+            return &value;
+        }
+    }
+    return nullptr;
+}
+
+const Json& Json::operator[](const string_view key) const {
+    const Json* value = Find(key);
+    if (value == nullptr) {
+        throw JsonError("missing \"" + string(key) + "\"");
+    }
+    return *value;
+}
+
+}
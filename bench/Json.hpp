@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Small JSON reader for the input files of the host tools. Numbers keep their text, so 64-bit amounts are read
+// without a detour through double.
+namespace bench {
+
+class JsonError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class Json {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    // throws JsonError on malformed input
+    static Json Parse(std::string_view text);
+
+    [[nodiscard]] Type GetType() const { return type; }
+    [[nodiscard]] bool IsNull() const { return type == Type::Null; }
+
+    // throw JsonError if the value is of another type
+    [[nodiscard]] bool GetBool() const;
+    [[nodiscard]] int64_t GetInt() const;
+    [[nodiscard]] uint64_t GetUInt() const;
+    [[nodiscard]] const std::string& GetString() const;
+    [[nodiscard]] const std::vector<Json>& GetItems() const;
+
+    // member of an object, nullptr if it is missing
+    [[nodiscard]] const Json* Find(std::string_view key) const;
+    // member of an object, throws JsonError if it is missing
+    [[nodiscard]] const Json& operator[](std::string_view key) const;
+
+private:
+    class Parser;
+
+    Type type = Type::Null;
+    bool boolean = false;
+    std::string text;   // string value or the literal of a number
+    std::vector<Json> items;
+    std::vector<std::pair<std::string, Json>> members;
+};
+
+}
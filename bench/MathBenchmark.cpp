@@ -0,0 +1,227 @@
+#include <Chain.hpp>
+#include <Util.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+
+using namespace std;
+
+// Checks the integer kernel from Math.hpp and the Util.hpp helpers built on it against the previous
+// __int128 implementations, exhaustively on small operands and on random ones, then times both.
+// The timings are native; in WASM the 128-bit divisions of the reference are libcalls and cost more.
+namespace {
+
+const uint64_t RANDOM_SEED = 20240501;
+const uint32_t RANDOM_CASES = 2000000;
+
+namespace reference {
+
+int64_t GetRateOf(int64_t value, int64_t rate) {
+    return static_cast<int64_t>(
+        (static_cast<int128_t>(value) * static_cast<int128_t>(rate)) / DEFAULT_FEE_PRECISION
+    ) / 100;
+}
+
+int64_t GetLiquidity(const int64_t in_amount, const int64_t supply, const int64_t pool) {
+    const uint128_t result = (static_cast<uint128_t>(in_amount) * static_cast<uint128_t>(supply))
+        / static_cast<uint128_t>(pool);
+    eosio::check(result <= static_cast<uint128_t>(eosio::asset::max_amount), "Transaction amount is too large");
+
+    return static_cast<int64_t>(result);
+}
+
+int64_t CalculateAmountWithoutFee(const int64_t total_amount, const int64_t rate) {
+    return static_cast<int64_t>(
+        (static_cast<int128_t>(total_amount) * MAX_FEE) / (static_cast<int128_t>(MAX_FEE) + rate)
+    );
+}
+
+// the initial supply of CreatePair
+int64_t InitialSupply(const int64_t amount1, const int64_t amount2) {
+    return int64_t(sqrt(double(int128_t(amount1) * int128_t(amount2))));
+}
+
+}
+
+uint32_t failures = 0;
+
+void Expect(const bool condition, const char* what, const uint64_t a, const uint64_t b, const uint64_t c) {
+    if (!condition) {
+        if (failures < 20) {
+            printf("mismatch: %s (%llu, %llu, %llu)\n", what, (unsigned long long) a, (unsigned long long) b,
+                   (unsigned long long) c);
+        }
+        failures++;
+    }
+}
+
+// result or -1 if the helper fails a check
+int64_t Outcome(const function<int64_t()>& helper) {
+    try {
+        return helper();
+    } catch (const host::AssertError&) {
+        return -1;
+    }
+}
+
+void CheckMulDiv(const uint64_t a, const uint64_t b, const uint64_t divisor) {
+    const uint128_t product = uint128_t(a) * b;
+    const uint128_t quotient = product / divisor;
+    const bool overflow = quotient >> 64 != 0;
+
+    Expect(MulDivDown(a, b, divisor) == (overflow ? UINT64_MAX_VALUE : uint64_t(quotient)), "MulDivDown", a, b,
+           divisor);
+    if (!overflow && quotient != UINT64_MAX_VALUE) {
+        Expect(MulDivUp(a, b, divisor) == uint64_t(quotient) + (product % divisor != 0), "MulDivUp", a, b, divisor);
+    }
+}
+
+void CheckISqrt(const uint128_t value) {
+    const uint128_t root = ISqrt(value);
+    const bool next_above = root == UINT64_MAX_VALUE || (root + 1) * (root + 1) > value;
+    Expect(root * root <= value && next_above, "ISqrt", uint64_t(value >> 64), uint64_t(value), 0);
+}
+
+void CheckHelpers(const int64_t a, const int64_t b, const int64_t c) {
+    // the reference overflows its int64_t intermediate above that
+    const int64_t rate = b % (MAX_FEE + 1);
+    if (int128_t(a) * rate / DEFAULT_FEE_PRECISION <= INT64_MAX) {
+        Expect(GetRateOf(a, rate) == reference::GetRateOf(a, rate), "GetRateOf", a, b, 0);
+    }
+    Expect(CalculateAmountWithoutFee(a, b % MAX_FEE) == reference::CalculateAmountWithoutFee(a, b % MAX_FEE),
+           "CalculateAmountWithoutFee", a, b, 0);
+    if (c > 0) {
+        const int64_t result = Outcome([&] { return GetLiquidity(a, b, c); });
+        Expect(result == Outcome([&] { return reference::GetLiquidity(a, b, c); }), "GetLiquidity", a, b, c);
+    }
+}
+
+void CheckExhaustive() {
+    for (uint64_t a = 0; a <= 64; a++) {
+        for (uint64_t b = 0; b <= 64; b++) {
+            for (uint64_t divisor = 1; divisor <= 64; divisor++) {
+                CheckMulDiv(a, b, divisor);
+                CheckMulDiv(UINT64_MAX_VALUE - a, UINT64_MAX_VALUE - b, divisor);
+                CheckMulDiv(UINT64_MAX_VALUE - a, b, UINT64_MAX_VALUE - divisor);
+                CheckHelpers(int64_t(a), int64_t(b), int64_t(divisor));
+            }
+        }
+    }
+
+    for (uint64_t value = 0; value < (uint64_t(1) << 20); value++) {
+        CheckISqrt(value);
+    }
+    for (uint32_t bits = 0; bits < 128; bits++) {
+        const uint128_t power = uint128_t(1) << bits;
+        CheckISqrt(power - 1);
+        CheckISqrt(power);
+        CheckISqrt(power + 1);
+    }
+    CheckISqrt(~uint128_t(0));
+}
+
+void CheckRandom() {
+    mt19937_64 random { RANDOM_SEED };
+
+    // random magnitudes reach the fast paths and the wide division alike
+    const auto operand = [&] { return random() >> (random() % 64); };
+
+    for (uint32_t i = 0; i < RANDOM_CASES; i++) {
+        const uint64_t a = operand();
+        const uint64_t b = operand();
+        const uint64_t divisor = max<uint64_t>(1, operand());
+        CheckMulDiv(a, b, divisor);
+
+        const uint128_t root = operand();
+        CheckISqrt(root * root);
+        CheckISqrt(root * root - 1);
+        CheckISqrt((uint128_t(random()) << 64) | random());
+
+        // amounts below the asset limit and rates in the fee range, as in the contract
+        const int64_t amount = int64_t(a >> 2) % (eosio::asset::max_amount + 1);
+        const int64_t rate = int64_t(random() % (MAX_FEE + 1));
+        const int64_t pool = int64_t(divisor >> 2) % (eosio::asset::max_amount + 1);
+        CheckHelpers(amount, rate, pool);
+        CheckHelpers(amount, int64_t(b >> 2), pool);
+
+        // initial supplies match the floating point sqrt while it is exact, far below 2^53
+        const int64_t amount1 = 1 + int64_t(random() % INIT_MAX);
+        const int64_t amount2 = 1 + int64_t(random() % INIT_MAX);
+        const uint128_t product = uint128_t(amount1) * uint128_t(amount2);
+        if (product < (uint128_t(1) << 48)) {
+            Expect(int64_t(ISqrt(product)) == reference::InitialSupply(amount1, amount2), "InitialSupply", amount1,
+                   amount2, 0);
+        }
+    }
+}
+
+template<typename Function>
+double Time(const char* name, Function&& function, const vector<uint64_t>& operands) {
+    uint64_t sink = 0;
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i + 2 < operands.size(); i += 3) {
+        sink += uint64_t(function(operands[i], operands[i + 1], operands[i + 2]));
+    }
+    const auto end = chrono::steady_clock::now();
+
+    const double nanoseconds = double(chrono::duration_cast<chrono::nanoseconds>(end - start).count())
+        / double(operands.size() / 3);
+    printf("%-40s %8.2f ns  (%llu)\n", name, nanoseconds, (unsigned long long) (sink & 0xFF));
+    return nanoseconds;
+}
+
+void RunBenchmark() {
+    mt19937_64 random { RANDOM_SEED };
+    vector<uint64_t> amounts;
+    vector<uint64_t> roots;
+    for (uint32_t i = 0; i < 3 * RANDOM_CASES; i++) {
+        amounts.push_back(1 + random() % uint64_t(INIT_MAX));
+        roots.push_back(1 + random() % uint64_t(INIT_MAX));
+    }
+
+    Time("GetRateOf, reference", [](uint64_t a, uint64_t b, uint64_t) {
+        return reference::GetRateOf(int64_t(a), int64_t(b % MAX_FEE));
+    }, amounts);
+    Time("GetRateOf", [](uint64_t a, uint64_t b, uint64_t) {
+        return GetRateOf(int64_t(a), int64_t(b % MAX_FEE));
+    }, amounts);
+
+    Time("GetLiquidity, reference", [](uint64_t a, uint64_t b, uint64_t c) {
+        return reference::GetLiquidity(int64_t(a % c), int64_t(b), int64_t(c));
+    }, amounts);
+    Time("GetLiquidity", [](uint64_t a, uint64_t b, uint64_t c) {
+        return GetLiquidity(int64_t(a % c), int64_t(b), int64_t(c));
+    }, amounts);
+
+    Time("CalculateAmountWithoutFee, reference", [](uint64_t a, uint64_t b, uint64_t) {
+        return reference::CalculateAmountWithoutFee(int64_t(a), int64_t(b % MAX_FEE));
+    }, amounts);
+    Time("CalculateAmountWithoutFee", [](uint64_t a, uint64_t b, uint64_t) {
+        return CalculateAmountWithoutFee(int64_t(a), int64_t(b % MAX_FEE));
+    }, amounts);
+
+    Time("initial supply, floating point sqrt", [](uint64_t a, uint64_t b, uint64_t) {
+        return reference::InitialSupply(int64_t(a), int64_t(b));
+    }, roots);
+    Time("initial supply, ISqrt", [](uint64_t a, uint64_t b, uint64_t) {
+        return int64_t(ISqrt(uint128_t(a) * b));
+    }, roots);
+}
+
+}
+
+int main() {
+    CheckExhaustive();
+    CheckRandom();
+    if (failures > 0) {
+        printf("%u mismatches\n", failures);
+        return 1;
+    }
+    printf("kernel matches the reference\n");
+
+    RunBenchmark();
+    return 0;
+}
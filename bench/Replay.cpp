@@ -0,0 +1,381 @@
+#include <Dex.hpp>
+#include "Json.hpp"
+#include "Results.hpp"
+#include "Snapshot.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+using namespace std;
+using namespace eosio;
+
+// Replays a log of recorded actions through the contract on the in-memory chain from host/, starting from a table
+// snapshot. The log has one action per line as in the action traces: {"account": ..., "name": ..., "data": {...}}
+// with the action data decoded to JSON and an optional "time" (seconds or "2024-05-01T12:00:00.000").
+// Token transfers to the contract are replayed as deposit notifications, other transfers are skipped.
+namespace {
+
+const uint32_t MAX_PRINTED_ERRORS = 20;
+
+struct Options {
+    string log;
+    string snapshot;
+    string expect;
+    string write_snapshot;
+    name self = "agora.dex"_n;
+    bench::ReportOptions report;
+};
+
+symbol ParseSymbol(const string& text) {
+    const size_t comma = text.find(',');
+    if (comma == string::npos) {
+        throw invalid_argument("invalid symbol " + text);
+    }
+    return { symbol_code { text.substr(comma + 1) }, uint8_t(stoi(text.substr(0, comma))) };
+}
+
+// "1.0000 ABC"
+asset ParseAsset(const string& text) {
+    const size_t space = text.find(' ');
+    if (space == string::npos) {
+        throw invalid_argument("invalid asset " + text);
+    }
+    const string amount = text.substr(0, space);
+    const size_t dot = amount.find('.');
+    const uint8_t precision = dot == string::npos ? 0 : uint8_t(amount.size() - dot - 1);
+
+    string digits = amount;
+    if (dot != string::npos) {
+        digits.erase(dot, 1);
+    }
+    return { stoll(digits), symbol { symbol_code { text.substr(space + 1) }, precision } };
+}
+
+name ParseName(const bench::Json& value) {
+    return name { value.GetString() };
+}
+
+extended_asset ParseExtendedAsset(const bench::Json& value) {
+    return { ParseAsset(value["quantity"].GetString()), ParseName(value["contract"]) };
+}
+
+extended_symbol ParseExtendedSymbol(const bench::Json& value) {
+    return { ParseSymbol(value["sym"].GetString()), ParseName(value["contract"]) };
+}
+
+// optional trailing "keep_on_deposit" of the swap and liquidity actions
+binary_extension<bool> ParseKeepOnDeposit(const bench::Json& data) {
+    binary_extension<bool> keep_on_deposit;
+    if (const bench::Json* value = data.Find("keep_on_deposit")) {
+        keep_on_deposit.emplace(value->GetBool());
+    }
+    return keep_on_deposit;
+}
+
+// microseconds since the epoch
+uint64_t ParseTime(const bench::Json& value) {
+    if (value.GetType() == bench::Json::Type::Number) {
+        return value.GetUInt() * 1000000;
+    }
+
+    tm parts {};
+    uint32_t milliseconds = 0;
+    const string& text = value.GetString();
+    if (sscanf(text.c_str(), "%d-%d-%dT%d:%d:%d.%u", &parts.tm_year, &parts.tm_mon, &parts.tm_mday, &parts.tm_hour,
+               &parts.tm_min, &parts.tm_sec, &milliseconds) < 6) {
+        throw invalid_argument("invalid time " + text);
+    }
+    parts.tm_year -= 1900;
+    parts.tm_mon -= 1;
+    return uint64_t(timegm(&parts)) * 1000000 + milliseconds * 1000;
+}
+
+class Replay {
+public:
+    explicit Replay(const Options& options) : options(options), dex(options.self) {}
+
+    bool LoadSnapshot() {
+        if (options.snapshot.empty()) {
+            return true;
+        }
+
+        vector<host::SnapshotRow> rows;
+        string error;
+        if (!bench::ReadSnapshot(options.snapshot, rows, error) || !dex.LoadRows(rows, &error)) {
+            cerr << "snapshot: " << error << endl;
+            return false;
+        }
+        printf("loaded %zu rows\n", rows.size());
+        return true;
+    }
+
+    bool Run() {
+        ifstream input { options.log };
+        if (!input) {
+            cerr << "cannot read " << options.log << endl;
+            return false;
+        }
+
+        string line;
+        for (uint64_t line_number = 1; getline(input, line); line_number++) {
+            if (line.empty()) {
+                continue;
+            }
+            try {
+                ReplayAction(bench::Json::Parse(line), line_number);
+            } catch (const exception& e) {
+                cerr << options.log << ":" << line_number << ": " << e.what() << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // reserves of every pair in the expected snapshot against the replayed ones, number of differences
+    uint32_t CheckReserves() const {
+        vector<host::SnapshotRow> rows;
+        string error;
+        if (!bench::ReadSnapshot(options.expect, rows, error)) {
+            cerr << "expected snapshot: " << error << endl;
+            return 1;
+        }
+
+        uint32_t mismatches = 0;
+        uint32_t pairs = 0;
+        for (const host::SnapshotRow& row : rows) {
+            if (row.table != "stat"_n) {
+                continue;
+            }
+            pairs++;
+
+            const auto expected = host::Dex::DecodePair(row.data);
+            const auto actual = dex.GetPair(expected.supply.symbol.code());
+            if (!actual) {
+                printf("reserves: %s is missing\n", expected.supply.symbol.code().to_string().c_str());
+                mismatches++;
+            } else if (actual->supply != expected.supply || actual->pool1 != expected.pool1
+                       || actual->pool2 != expected.pool2 || actual->raw_pool1_amount != expected.raw_pool1_amount
+                       || actual->raw_pool2_amount != expected.raw_pool2_amount) {
+                printf("reserves: %s is %s %s %s (%lld %lld), expected %s %s %s (%lld %lld)\n",
+                       expected.supply.symbol.code().to_string().c_str(), actual->supply.to_string().c_str(),
+                       actual->pool1.quantity.to_string().c_str(), actual->pool2.quantity.to_string().c_str(),
+                       (long long) actual->raw_pool1_amount, (long long) actual->raw_pool2_amount,
+                       expected.supply.to_string().c_str(), expected.pool1.quantity.to_string().c_str(),
+                       expected.pool2.quantity.to_string().c_str(), (long long) expected.raw_pool1_amount,
+                       (long long) expected.raw_pool2_amount);
+                mismatches++;
+            }
+        }
+
+        printf("reserves of %u pairs checked, %u differ\n", pairs, mismatches);
+        return mismatches;
+    }
+
+    void PrintSummary() const {
+        const double seconds = double(total_nanoseconds) / 1e9;
+        printf("replayed %llu actions in %.3f s, %.0f actions/s; %llu failed, %llu skipped\n",
+               (unsigned long long) replayed, seconds, seconds > 0 ? double(replayed) / seconds : 0.0,
+               (unsigned long long) failed, (unsigned long long) skipped);
+        for (const auto& [action_name, count] : skipped_actions) {
+            printf("  skipped %s: %llu\n", action_name.c_str(), (unsigned long long) count);
+        }
+    }
+
+    [[nodiscard]] host::Dex& GetDex() { return dex; }
+    [[nodiscard]] const map<string, bench::Samples>& GetResults() const { return results; }
+    [[nodiscard]] uint64_t GetFailed() const { return failed; }
+
+private:
+    void ReplayAction(const bench::Json& entry, const uint64_t line_number) {
+        if (const bench::Json* time = entry.Find("time")) {
+            host::Chain::Get().SetTime(ParseTime(*time));
+        }
+
+        const name account = ParseName(entry["account"]);
+        const string& action_name = entry["name"].GetString();
+        const bench::Json& data = entry["data"];
+
+        if (account != options.self) {
+            if (action_name != "transfer" || ParseName(data["to"]) != options.self) {
+                Skip(account.to_string() + "::" + action_name);
+                return;
+            }
+
+            const name from = ParseName(data["from"]);
+            const asset quantity = ParseAsset(data["quantity"].GetString());
+            const string& memo = data["memo"].GetString();
+            AddAccounts({ from });
+            Measure(memo.rfind("swap:", 0) == 0 ? "transfer.swap" : "transfer", line_number, [&](string& error) {
+                return dex.Deposit(account, from, quantity, memo, &error);
+            });
+            return;
+        }
+
+        if (action_name == "swap") {
+            const name user = ParseName(data["user"]);
+            const symbol pair_token = ParseSymbol(data["pair_token"].GetString());
+            const extended_asset max_in = ParseExtendedAsset(data["max_in"]);
+            const extended_asset expected_out = ParseExtendedAsset(data["expected_out"]);
+            const binary_extension<bool> keep_on_deposit = ParseKeepOnDeposit(data);
+            RunAction(action_name, line_number, { user }, [&](Contract& contract) {
+                contract.Swap(user, pair_token, max_in, expected_out, keep_on_deposit);
+            });
+        } else if (action_name == "swap.in") {
+            const name user = ParseName(data["user"]);
+            const symbol pair_token = ParseSymbol(data["pair_token"].GetString());
+            const extended_asset in = ParseExtendedAsset(data["in"]);
+            const extended_asset min_out = ParseExtendedAsset(data["min_out"]);
+            const binary_extension<bool> keep_on_deposit = ParseKeepOnDeposit(data);
+            RunAction(action_name, line_number, { user }, [&](Contract& contract) {
+                contract.SwapIn(user, pair_token, in, min_out, keep_on_deposit);
+            });
+        } else if (action_name == "addliquidity") {
+            const name user = ParseName(data["user"]);
+            const symbol token = ParseSymbol(data["token"].GetString());
+            const extended_asset max_asset1 = ParseExtendedAsset(data["max_asset1"]);
+            const extended_asset max_asset2 = ParseExtendedAsset(data["max_asset2"]);
+            const binary_extension<bool> keep_on_deposit = ParseKeepOnDeposit(data);
+            RunAction(action_name, line_number, { user }, [&](Contract& contract) {
+                contract.AddLiquidity(user, token, max_asset1, max_asset2, keep_on_deposit);
+            });
+        } else if (action_name == "remliquidity") {
+            const name user = ParseName(data["user"]);
+            const asset to_sell = ParseAsset(data["to_sell"].GetString());
+            const extended_asset min_asset1 = ParseExtendedAsset(data["min_asset1"]);
+            const extended_asset min_asset2 = ParseExtendedAsset(data["min_asset2"]);
+            const binary_extension<bool> keep_on_deposit = ParseKeepOnDeposit(data);
+            RunAction(action_name, line_number, { user }, [&](Contract& contract) {
+                contract.RemoveLiquidity(user, to_sell, min_asset1, min_asset2, keep_on_deposit);
+            });
+        } else if (action_name == "withdraw") {
+            const name user = ParseName(data["user"]);
+            const extended_symbol token = ParseExtendedSymbol(data["token"]);
+            RunAction(action_name, line_number, { user }, [&](Contract& contract) {
+                contract.Withdraw(user, token);
+            });
+        } else if (action_name == "transfer") {
+            const name from = ParseName(data["from"]);
+            const name to = ParseName(data["to"]);
+            const asset quantity = ParseAsset(data["quantity"].GetString());
+            const string& memo = data["memo"].GetString();
+            AddAccounts({ to });
+            RunAction("transfer.lp", line_number, { from }, [&](Contract& contract) {
+                contract.Transfer(from, to, quantity, memo);
+            });
+        } else {
+            Skip(action_name);
+        }
+    }
+
+    template<typename Action>
+    void RunAction(const string& label, const uint64_t line_number, const vector<name>& auths, Action&& action) {
+        AddAccounts(auths);
+        Measure(label, line_number, [&](string& error) {
+            return dex.Run(auths, action, &error);
+        });
+    }
+
+    template<typename Action>
+    void Measure(const string& label, const uint64_t line_number, Action&& action) {
+        string error;
+        const auto start = chrono::steady_clock::now();
+        const bool success = action(error);
+        const auto end = chrono::steady_clock::now();
+
+        const uint64_t nanoseconds = uint64_t(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        bench::AddSample(results, "replay/" + label, success, nanoseconds);
+        total_nanoseconds += nanoseconds;
+        replayed++;
+
+        if (!success) {
+            if (failed < MAX_PRINTED_ERRORS) {
+                printf("%s:%llu: %s failed: %s\n", options.log.c_str(), (unsigned long long) line_number,
+                       label.c_str(), error.c_str());
+            }
+            failed++;
+        }
+    }
+
+    void Skip(const string& action_name) {
+        skipped_actions[action_name]++;
+        skipped++;
+    }
+
+    // accounts of the log are created on first use, is_account holds for them
+    static void AddAccounts(const vector<name>& accounts) {
+        for (const name& account : accounts) {
+            host::Chain::Get().AddAccount(account.value);
+        }
+    }
+
+    const Options& options;
+    host::Dex dex;
+    map<string, bench::Samples> results;
+    map<string, uint64_t> skipped_actions;
+    uint64_t total_nanoseconds = 0;
+    uint64_t replayed = 0;
+    uint64_t failed = 0;
+    uint64_t skipped = 0;
+};
+
+bool ParseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const string argument = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (bench::ParseReportOption(argc, argv, i, options.report)) {
+            continue;
+        }
+        if (argument == "--snapshot" && has_value) {
+            options.snapshot = argv[++i];
+        } else if (argument == "--expect" && has_value) {
+            options.expect = argv[++i];
+        } else if (argument == "--write-snapshot" && has_value) {
+            options.write_snapshot = argv[++i];
+        } else if (argument == "--contract" && has_value) {
+            options.self = name { argv[++i] };
+        } else if (argument[0] != '-' && options.log.empty()) {
+            options.log = argument;
+        } else {
+            return false;
+        }
+    }
+    return !options.log.empty();
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        cerr << "usage: dex-replay <log> [--snapshot <file>] [--expect <snapshot>] [--write-snapshot <file>]" << endl
+             << "    [--contract <name>] " << bench::REPORT_USAGE << endl;
+        return 2;
+    }
+
+#ifndef DEX_INSTRUMENTATION
+    cerr << "built without DEX_INSTRUMENTATION, operation counts are zero" << endl;
+#endif
+
+    Replay replay { options };
+    if (!replay.LoadSnapshot() || !replay.Run()) {
+        return 2;
+    }
+    replay.PrintSummary();
+
+    if (!options.write_snapshot.empty() && !bench::WriteSnapshot(options.write_snapshot, replay.GetDex().GetRows())) {
+        cerr << "cannot write " << options.write_snapshot << endl;
+        return 2;
+    }
+
+    const int report = bench::Report(replay.GetResults(), options.report, "dex-replay");
+    // the logged actions succeeded on chain, a failure in the replay is a difference as well
+    if (!options.expect.empty() && (replay.CheckReserves() > 0 || replay.GetFailed() > 0)) {
+        return 1;
+    }
+    return report;
+}
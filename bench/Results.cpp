@@ -0,0 +1,206 @@
+#include "Results.hpp"
+
+#include <Chain.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace bench {
+
+const char* const REPORT_USAGE = "[--baseline <file>] [--write-baseline <file>] [--compare <file>]\n"
+                                 "    [--margin <percent>] [--check-latency] [--latency-margin <percent>]";
+
+void AddSample(map<string, Samples>& results, const string& key, const bool success, const uint64_t nanoseconds) {
+    Samples& samples = results[key];
+    if (!success) {
+        samples.failures++;
+        return;
+    }
+    samples.nanoseconds.push_back(nanoseconds);
+    samples.metrics += host::Chain::Get().GetMetrics();
+}
+
+uint64_t Operations(const host::OperationCounters& counters) {
+    return counters.finds + counters.iterations + counters.reads + counters.emplaces + counters.modifies
+        + counters.erases;
+}
+
+uint64_t Percentile(vector<uint64_t> values, const double quantile) {
+    if (values.empty()) {
+        return 0;
+    }
+    sort(values.begin(), values.end());
+    return values[min(values.size() - 1, size_t(double(values.size()) * quantile))];
+}
+
+Baseline Summarize(const map<string, Samples>& results) {
+    Baseline summary;
+    for (const auto& [key, samples] : results) {
+        if (samples.nanoseconds.empty()) {
+            continue;
+        }
+        const double runs = double(samples.nanoseconds.size());
+        summary[{ key, "operations" }] = double(Operations(samples.metrics.Total())) / runs;
+        summary[{ key, "bytes_written" }] = double(samples.metrics.Total().bytes_written) / runs;
+        summary[{ key, "allocations" }] = double(samples.metrics.allocations) / runs;
+        summary[{ key, "p50_ns" }] = double(Percentile(samples.nanoseconds, 0.5));
+    }
+    return summary;
+}
+
+void PrintResults(const map<string, Samples>& results) {
+    printf("%-32s %6s %5s %9s %9s %9s %9s %8s %8s %8s\n", "action", "runs", "fail", "p50 us", "p90 us", "p99 us",
+           "max us", "ops", "writes", "allocs");
+
+    for (const auto& [key, samples] : results) {
+        const double runs = max<double>(1, double(samples.nanoseconds.size()));
+        const host::OperationCounters total = samples.metrics.Total();
+        printf("%-32s %6zu %5llu %9.2f %9.2f %9.2f %9.2f %8.1f %8.1f %8.1f\n", key.c_str(),
+               samples.nanoseconds.size(), (unsigned long long) samples.failures,
+               double(Percentile(samples.nanoseconds, 0.5)) / 1000, double(Percentile(samples.nanoseconds, 0.9)) / 1000,
+               double(Percentile(samples.nanoseconds, 0.99)) / 1000,
+               double(Percentile(samples.nanoseconds, 1.0)) / 1000,
+               double(Operations(total)) / runs, double(total.emplaces + total.modifies + total.erases) / runs,
+               double(samples.metrics.allocations) / runs);
+    }
+}
+
+bool ReadBaseline(const string& path, Baseline& baseline) {
+    ifstream input { path };
+    if (!input) {
+        return false;
+    }
+
+    string line;
+    while (getline(input, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        istringstream fields { line };
+        string key;
+        string metric;
+        double value = 0;
+        if (fields >> key >> metric >> value) {
+            baseline[{ key, metric }] = value;
+        }
+    }
+    return true;
+}
+
+void WriteBaseline(const string& path, const Baseline& summary, const string& tool) {
+    ofstream output { path };
+    output << "# <scenario/action> <metric> <value>, written by " << tool << " --write-baseline\n";
+    for (const auto& [id, value] : summary) {
+        output << id.first << " " << id.second << " " << value << "\n";
+    }
+}
+
+uint32_t CheckBaseline(const Baseline& baseline, const Baseline& summary, const ReportOptions& options) {
+    uint32_t regressions = 0;
+
+    for (const auto& [id, expected] : baseline) {
+        const bool latency = id.second == "p50_ns";
+        if (latency && !options.check_latency) {
+            continue;
+        }
+
+        const auto actual_it = summary.find(id);
+        if (actual_it == summary.end()) {
+            printf("missing: %s %s\n", id.first.c_str(), id.second.c_str());
+            regressions++;
+            continue;
+        }
+
+        const double limit = expected * (1 + (latency ? options.latency_margin : options.margin));
+        if (actual_it->second > limit) {
+            printf("regression: %s %s %.1f, baseline %.1f\n", id.first.c_str(), id.second.c_str(), actual_it->second,
+                   expected);
+            regressions++;
+        }
+    }
+
+    return regressions;
+}
+
+void PrintComparison(const Baseline& before, const Baseline& after) {
+    printf("%-32s %12s %12s %8s %10s %10s\n", "action", "p50 us was", "p50 us", "change", "ops was", "ops");
+
+    for (const auto& [id, value] : after) {
+        if (id.second != "p50_ns") {
+            continue;
+        }
+        const auto latency_it = before.find(id);
+        const auto operations_it = before.find({ id.first, "operations" });
+        const auto after_operations_it = after.find({ id.first, "operations" });
+        if (latency_it == before.end() || operations_it == before.end() || latency_it->second <= 0) {
+            printf("%-32s %12s %12.2f\n", id.first.c_str(), "-", value / 1000);
+            continue;
+        }
+        printf("%-32s %12.2f %12.2f %7.1f%% %10.1f %10.1f\n", id.first.c_str(), latency_it->second / 1000,
+               value / 1000, (value / latency_it->second - 1) * 100, operations_it->second,
+               after_operations_it->second);
+    }
+}
+
+bool ParseReportOption(const int argc, char** argv, int& i, ReportOptions& options) {
+    const string argument = argv[i];
+    const bool has_value = i + 1 < argc;
+
+    if (argument == "--baseline" && has_value) {
+        options.baseline = argv[++i];
+    } else if (argument == "--write-baseline" && has_value) {
+        options.write_baseline = argv[++i];
+    } else if (argument == "--compare" && has_value) {
+        options.compare = argv[++i];
+    } else if (argument == "--margin" && has_value) {
+        options.margin = stod(argv[++i]) / 100;
+    } else if (argument == "--latency-margin" && has_value) {
+        options.latency_margin = stod(argv[++i]) / 100;
+    } else if (argument == "--check-latency") {
+        options.check_latency = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int Report(const map<string, Samples>& results, const ReportOptions& options, const string& tool) {
+    PrintResults(results);
+    const Baseline summary = Summarize(results);
+
+    if (!options.write_baseline.empty()) {
+        WriteBaseline(options.write_baseline, summary, tool);
+    }
+
+    if (!options.compare.empty()) {
+        Baseline before;
+        if (!ReadBaseline(options.compare, before)) {
+            cerr << "cannot read " << options.compare << endl;
+            return 2;
+        }
+        PrintComparison(before, summary);
+    }
+
+    if (!options.baseline.empty()) {
+        Baseline baseline;
+        if (!ReadBaseline(options.baseline, baseline)) {
+            cerr << "cannot read " << options.baseline << endl;
+            return 2;
+        }
+        const uint32_t regressions = CheckBaseline(baseline, summary, options);
+        if (regressions > 0) {
+            printf("%u metrics above the baseline\n", regressions);
+            return 1;
+        }
+        printf("within the baseline\n");
+    }
+
+    return 0;
+}
+
+}
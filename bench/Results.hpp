@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Metrics.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Latency and operation counts per "scenario/action", shared by dex-bench and dex-replay, and the baseline
+// file both of them write and check.
+namespace bench {
+
+struct Samples {
+    std::vector<uint64_t> nanoseconds;
+    host::ActionMetrics metrics;    // sum over the successful runs
+    uint64_t failures = 0;
+};
+
+struct ReportOptions {
+    std::string baseline;
+    std::string write_baseline;
+    std::string compare;
+    double margin = 0.10;
+    double latency_margin = 0.50;
+    bool check_latency = false;
+};
+
+// baseline lines are "<scenario/action> <metric> <value>"
+typedef std::map<std::pair<std::string, std::string>, double> Baseline;
+
+// adds a run of "key" with the metrics of the last host action
+void AddSample(std::map<std::string, Samples>& results, const std::string& key, bool success, uint64_t nanoseconds);
+
+uint64_t Operations(const host::OperationCounters& counters);
+uint64_t Percentile(std::vector<uint64_t> values, double quantile);
+
+Baseline Summarize(const std::map<std::string, Samples>& results);
+void PrintResults(const std::map<std::string, Samples>& results);
+
+bool ReadBaseline(const std::string& path, Baseline& baseline);
+void WriteBaseline(const std::string& path, const Baseline& summary, const std::string& tool);
+// number of metrics above the baseline by more than the margin
+uint32_t CheckBaseline(const Baseline& baseline, const Baseline& summary, const ReportOptions& options);
+
+// latency and operations of every action next to the ones of an earlier run, without checking them
+void PrintComparison(const Baseline& before, const Baseline& after);
+
+// parses the baseline option at argv[i] and moves i past its value, false if it is not one
+bool ParseReportOption(int argc, char** argv, int& i, ReportOptions& options);
+extern const char* const REPORT_USAGE;
+
+// prints the results, writes and checks the baseline; returns the exit code of the tool
+int Report(const std::map<std::string, Samples>& results, const ReportOptions& options, const std::string& tool);
+
+}
@@ -0,0 +1,93 @@
+#include "Snapshot.hpp"
+#include "Json.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace eosio;
+
+namespace bench {
+
+namespace {
+
+int HexDigit(const char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    throw invalid_argument("invalid hex character");
+}
+
+}
+
+string ToHex(const vector<char>& data) {
+    static const char* const DIGITS = "0123456789abcdef";
+
+    string result;
+    result.reserve(data.size() * 2);
+    for (const char c : data) {
+        result.push_back(DIGITS[uint8_t(c) >> 4]);
+        result.push_back(DIGITS[uint8_t(c) & 0xF]);
+    }
+    return result;
+}
+
+vector<char> FromHex(const string& text) {
+    if (text.size() % 2 != 0) {
+        throw invalid_argument("odd length of hex data");
+    }
+
+    vector<char> result(text.size() / 2);
+    for (size_t i = 0; i < result.size(); i++) {
+        result[i] = char(HexDigit(text[2 * i]) << 4 | HexDigit(text[2 * i + 1]));
+    }
+    return result;
+}
+
+bool ReadSnapshot(const string& path, vector<host::SnapshotRow>& rows, string& error) {
+    ifstream input { path };
+    if (!input) {
+        error = "cannot read " + path;
+        return false;
+    }
+
+    string line;
+    for (uint64_t line_number = 1; getline(input, line); line_number++) {
+        if (line.empty()) {
+            continue;
+        }
+
+        try {
+            const Json row = Json::Parse(line);
+            const Json& scope = row["scope"];
+
+            rows.push_back({
+                name { row["table"].GetString() },
+                scope.GetType() == Json::Type::Number ? scope.GetUInt() : name { scope.GetString() }.value,
+                name { row["payer"].GetString() },
+                FromHex(row["data"].GetString())
+            });
+        } catch (const exception& e) {
+            error = path + ":" + to_string(line_number) + ": " + e.what();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WriteSnapshot(const string& path, const vector<host::SnapshotRow>& rows) {
+    ofstream output { path };
+    for (const host::SnapshotRow& row : rows) {
+        output << R"({"table":")" << row.table.to_string() << R"(","scope":)" << row.scope << R"(,"payer":")"
+               << row.payer.to_string() << R"(","data":")" << ToHex(row.data) << "\"}\n";
+    }
+    return bool(output);
+}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Dex.hpp>
+
+#include <string>
+#include <vector>
+
+// Table snapshots of the host tools: JSON lines {"table": ..., "scope": ..., "payer": ..., "data": "<hex>"},
+// one per row, with "data" as returned by get_table_rows without "json". The scope is a number or a name.
+namespace bench {
+
+// false with the line and the reason in "error" if the file cannot be read
+bool ReadSnapshot(const std::string& path, std::vector<host::SnapshotRow>& rows, std::string& error);
+bool WriteSnapshot(const std::string& path, const std::vector<host::SnapshotRow>& rows);
+
+std::string ToHex(const std::vector<char>& data);
+// throws std::invalid_argument on odd length or a non-hex character
+std::vector<char> FromHex(const std::string& text);
+
+}
@@ -0,0 +1,768 @@
+#include "Chain.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+#ifdef DEX_INSTRUMENTATION
+#define HOST_COUNT(METRICS, INDEX_ID, FIELD, VALUE) ((METRICS).indexes[INDEX_ID].FIELD += (VALUE))
+#else
+#define HOST_COUNT(METRICS, INDEX_ID, FIELD, VALUE) ((void) 0)
+#endif
+
+namespace host {
+
+Chain& Chain::Get() {
+    static Chain chain;
+    return chain;
+}
+
+Chain& Chain::Intrinsic(const IntrinsicScope&) {
+    return Get();
+}
+
+void Chain::AddAccount(const uint64_t account) {
+    accounts.insert(account);
+}
+
+bool Chain::IsAccount(const uint64_t account) const {
+    return accounts.count(account) > 0;
+}
+
+void Chain::BeginAction(const uint64_t new_receiver, vector<uint64_t> new_auths) {
+    receiver = new_receiver;
+    auths = std::move(new_auths);
+
+    journal.clear();
+    inline_actions.clear();
+    recipients.clear();
+    metrics = {};
+}
+
+void Chain::CommitAction() {
+    journal.clear();
+    iterators.clear();
+    idx64.ClearIterators();
+    idx128.ClearIterators();
+    idx256.ClearIterators();
+}
+
+void Chain::RevertAction() {
+    for (auto undo_it = journal.rbegin(); undo_it != journal.rend(); ++undo_it) {
+        (*undo_it)();
+    }
+    inline_actions.clear();
+    recipients.clear();
+    CommitAction();
+}
+
+bool Chain::Run(const uint64_t action_receiver, vector<uint64_t> action_auths, const function<void()>& action,
+                string* error) {
+    BeginAction(action_receiver, std::move(action_auths));
+    try {
+        SetAllocationCounting(true, &metrics);
+        action();
+        SetAllocationCounting(false, nullptr);
+    } catch (const AssertError& e) {
+        SetAllocationCounting(false, nullptr);
+        RevertAction();
+        if (error != nullptr) {
+            *error = e.what();
+        }
+        return false;
+    }
+    CommitAction();
+
+    if (print_metrics) {
+        fputs(metrics.ToString().c_str(), stderr);
+    }
+    return true;
+}
+
+bool Chain::HasAuth(const uint64_t actor) const {
+    return find(auths.begin(), auths.end(), actor) != auths.end();
+}
+
+void Chain::RequireAuth(const uint64_t actor) const {
+    if (!HasAuth(actor)) {
+        throw AssertError("missing required authority");
+    }
+}
+
+void Chain::RequireRecipient(const uint64_t recipient) {
+    if (find(recipients.begin(), recipients.end(), recipient) == recipients.end()) {
+        recipients.push_back(recipient);
+    }
+}
+
+void Chain::SendInline(const char* data, const size_t size) {
+    inline_actions.emplace_back(data, data + size);
+
+#ifdef DEX_INSTRUMENTATION
+    metrics.inline_actions++;
+    metrics.inline_action_bytes += size;
+#endif
+}
+
+PrimaryTable* Chain::FindTable(const TableId& id) {
+    const auto index_it = table_index.find(id);
+    return index_it == table_index.end() ? nullptr : tables[index_it->second].get();
+}
+
+PrimaryTable& Chain::GetTable(const TableId& id) {
+    PrimaryTable* table = FindTable(id);
+    if (table != nullptr) {
+        return *table;
+    }
+
+    table_index[id] = tables.size();
+    tables.push_back(make_unique<PrimaryTable>());
+    tables.back()->id = id;
+    return *tables.back();
+}
+
+int32_t Chain::GetEnd(const PrimaryTable& table) const {
+    return -static_cast<int32_t>(table_index.at(table.id)) - 2;
+}
+
+int32_t Chain::AddIterator(PrimaryTable& table, const uint64_t primary) {
+    iterators.emplace_back(&table, primary);
+    return static_cast<int32_t>(iterators.size() - 1);
+}
+
+pair<PrimaryTable*, uint64_t> Chain::GetIterator(const int32_t iterator) {
+    if (iterator < 0 || iterator >= static_cast<int32_t>(iterators.size())) {
+        throw AssertError("dereference of invalid iterator");
+    }
+    const auto [table, primary] = iterators[iterator];
+    if (table->rows.count(primary) == 0) {
+        throw AssertError("dereference of deleted object");
+    }
+    return iterators[iterator];
+}
+
+int32_t Chain::Store(const uint64_t scope, const uint64_t table, const uint64_t payer, const uint64_t primary,
+                     const void* data, const uint32_t size) {
+    PrimaryTable& primary_table = GetTable({ receiver, scope, table });
+    if (primary_table.rows.count(primary) > 0) {
+        throw AssertError("db access violation: primary key already exists");
+    }
+
+    const char* bytes = static_cast<const char*>(data);
+    primary_table.rows[primary] = { payer, { bytes, bytes + size } };
+    journal.emplace_back([&primary_table, primary] { primary_table.rows.erase(primary); });
+
+    HOST_COUNT(metrics, IndexId(table, -1), emplaces, 1);
+    HOST_COUNT(metrics, IndexId(table, -1), bytes_written, size);
+
+    return AddIterator(primary_table, primary);
+}
+
+void Chain::Update(const int32_t iterator, const uint64_t payer, const void* data, const uint32_t size) {
+    const auto [table, primary] = GetIterator(iterator);
+    if (table->id.code != receiver) {
+        throw AssertError("db access violation: table of another contract");
+    }
+
+    Row& row = table->rows[primary];
+    journal.emplace_back([table = table, primary = primary, old_row = row] { table->rows[primary] = old_row; });
+
+    const char* bytes = static_cast<const char*>(data);
+    row.payer = payer;
+    row.data.assign(bytes, bytes + size);
+
+    HOST_COUNT(metrics, IndexId(table->id.table, -1), modifies, 1);
+    HOST_COUNT(metrics, IndexId(table->id.table, -1), bytes_written, size);
+}
+
+void Chain::Remove(const int32_t iterator) {
+    const auto [table, primary] = GetIterator(iterator);
+    if (table->id.code != receiver) {
+        throw AssertError("db access violation: table of another contract");
+    }
+
+    const auto row_it = table->rows.find(primary);
+    journal.emplace_back([table = table, primary = primary, old_row = row_it->second] {
+        table->rows[primary] = old_row;
+    });
+    table->rows.erase(row_it);
+
+    HOST_COUNT(metrics, IndexId(table->id.table, -1), erases, 1);
+}
+
+int32_t Chain::GetRow(const int32_t iterator, void* data, const uint32_t size) {
+    const auto [table, primary] = GetIterator(iterator);
+    const Row& row = table->rows.at(primary);
+
+    if (size == 0) {
+        return static_cast<int32_t>(row.data.size());
+    }
+    const size_t to_copy = min<size_t>(size, row.data.size());
+    memcpy(data, row.data.data(), to_copy);
+
+    HOST_COUNT(metrics, IndexId(table->id.table, -1), reads, 1);
+    HOST_COUNT(metrics, IndexId(table->id.table, -1), bytes_read, to_copy);
+
+    return static_cast<int32_t>(row.data.size());
+}
+
+int32_t Chain::Next(const int32_t iterator, uint64_t* primary) {
+    if (iterator < -1) {
+        return -1;
+    }
+    const auto [table, current] = GetIterator(iterator);
+    HOST_COUNT(metrics, IndexId(table->id.table, -1), iterations, 1);
+
+    const auto row_it = table->rows.upper_bound(current);
+    if (row_it == table->rows.end()) {
+        return GetEnd(*table);
+    }
+
+    *primary = row_it->first;
+    return AddIterator(*table, row_it->first);
+}
+
+int32_t Chain::Previous(const int32_t iterator, uint64_t* primary) {
+    if (iterator < -1) {
+        PrimaryTable& table = *tables.at(-(iterator + 2));
+        HOST_COUNT(metrics, IndexId(table.id.table, -1), iterations, 1);
+        if (table.rows.empty()) {
+            return -1;
+        }
+
+        *primary = table.rows.rbegin()->first;
+        return AddIterator(table, *primary);
+    }
+    const auto [table, current] = GetIterator(iterator);
+    HOST_COUNT(metrics, IndexId(table->id.table, -1), iterations, 1);
+
+    const auto row_it = table->rows.find(current);
+    if (row_it == table->rows.begin()) {
+        return -1;
+    }
+
+    *primary = prev(row_it)->first;
+    return AddIterator(*table, *primary);
+}
+
+int32_t Chain::Find(const uint64_t code, const uint64_t scope, const uint64_t table, const uint64_t primary) {
+    HOST_COUNT(metrics, IndexId(table, -1), finds, 1);
+
+    PrimaryTable* primary_table = FindTable({ code, scope, table });
+    if (primary_table == nullptr) {
+        return -1;
+    }
+
+    if (primary_table->rows.count(primary) == 0) {
+        return GetEnd(*primary_table);
+    }
+    return AddIterator(*primary_table, primary);
+}
+
+int32_t Chain::LowerBound(const uint64_t code, const uint64_t scope, const uint64_t table, const uint64_t primary) {
+    HOST_COUNT(metrics, IndexId(table, -1), finds, 1);
+
+    PrimaryTable* primary_table = FindTable({ code, scope, table });
+    if (primary_table == nullptr) {
+        return -1;
+    }
+
+    const auto row_it = primary_table->rows.lower_bound(primary);
+    if (row_it == primary_table->rows.end()) {
+        return GetEnd(*primary_table);
+    }
+    return AddIterator(*primary_table, row_it->first);
+}
+
+int32_t Chain::UpperBound(const uint64_t code, const uint64_t scope, const uint64_t table, const uint64_t primary) {
+    HOST_COUNT(metrics, IndexId(table, -1), finds, 1);
+
+    PrimaryTable* primary_table = FindTable({ code, scope, table });
+    if (primary_table == nullptr) {
+        return -1;
+    }
+
+    const auto row_it = primary_table->rows.upper_bound(primary);
+    if (row_it == primary_table->rows.end()) {
+        return GetEnd(*primary_table);
+    }
+    return AddIterator(*primary_table, row_it->first);
+}
+
+int32_t Chain::End(const uint64_t code, const uint64_t scope, const uint64_t table) {
+    HOST_COUNT(metrics, IndexId(table, -1), finds, 1);
+
+    PrimaryTable* primary_table = FindTable({ code, scope, table });
+    return primary_table == nullptr ? -1 : GetEnd(*primary_table);
+}
+
+void Chain::ForEachRow(const uint64_t code, const uint64_t table,
+                       const function<void(uint64_t scope, uint64_t primary, const Row& row)>& callback) const {
+    for (const auto& [id, index] : table_index) {
+        if (id.code != code || id.table != table) {
+            continue;
+        }
+        for (const auto& [primary, row] : tables[index]->rows) {
+            callback(id.scope, primary, row);
+        }
+    }
+}
+
+void Chain::Reset() {
+    CommitAction();
+    table_index.clear();
+    tables.clear();
+    idx64 = {};
+    idx128 = {};
+    idx256 = {};
+    metrics = {};
+    accounts.clear();
+    auths.clear();
+    inline_actions.clear();
+    recipients.clear();
+    receiver = 0;
+    time = 0;
+}
+
+template<typename Key>
+SecondaryTable<Key>* SecondaryIndex<Key>::FindTable(const TableId& id) {
+    const auto index_it = table_index.find(id);
+    return index_it == table_index.end() ? nullptr : tables[index_it->second].get();
+}
+
+template<typename Key>
+SecondaryTable<Key>& SecondaryIndex<Key>::GetTable(const TableId& id) {
+    SecondaryTable<Key>* table = FindTable(id);
+    if (table != nullptr) {
+        return *table;
+    }
+
+    table_index[id] = tables.size();
+    tables.push_back(make_unique<SecondaryTable<Key>>());
+    tables.back()->id = id;
+    return *tables.back();
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::GetEnd(const SecondaryTable<Key>& table) const {
+    return -static_cast<int32_t>(table_index.at(table.id)) - 2;
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::AddIterator(SecondaryTable<Key>& table, const uint64_t primary) {
+    iterators.emplace_back(&table, primary);
+    return static_cast<int32_t>(iterators.size() - 1);
+}
+
+template<typename Key>
+pair<SecondaryTable<Key>*, uint64_t> SecondaryIndex<Key>::GetIterator(const int32_t iterator) {
+    if (iterator < 0 || iterator >= static_cast<int32_t>(iterators.size())) {
+        throw AssertError("dereference of invalid secondary iterator");
+    }
+    const auto [table, primary] = iterators[iterator];
+    if (table->by_primary.count(primary) == 0) {
+        throw AssertError("dereference of deleted secondary object");
+    }
+    return iterators[iterator];
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::Found(SecondaryTable<Key>& table,
+                                   const typename set<pair<Key, uint64_t>>::const_iterator it,
+                                   Key* secondary, uint64_t* primary) {
+    if (it == table.by_secondary.end()) {
+        return GetEnd(table);
+    }
+    if (secondary != nullptr) {
+        *secondary = it->first;
+    }
+    *primary = it->second;
+    return AddIterator(table, it->second);
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::Store(const TableId& id, const uint64_t payer, const uint64_t primary,
+                                   const Key& secondary) {
+    SecondaryTable<Key>& table = GetTable(id);
+    if (table.by_primary.count(primary) > 0) {
+        throw AssertError("db access violation: secondary key of the primary key already exists");
+    }
+
+    table.by_primary[primary] = { secondary, payer };
+    table.by_secondary.insert({ secondary, primary });
+
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(id.table), emplaces, 1);
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(id.table), bytes_written, sizeof(Key));
+    Chain::Get().journal.emplace_back([&table, primary, secondary] {
+        table.by_primary.erase(primary);
+        table.by_secondary.erase({ secondary, primary });
+    });
+
+    return AddIterator(table, primary);
+}
+
+template<typename Key>
+void SecondaryIndex<Key>::Update(const int32_t iterator, const uint64_t payer, const Key& secondary) {
+    const auto [table, primary] = GetIterator(iterator);
+
+    auto& [old_secondary, old_payer] = table->by_primary[primary];
+    Chain::Get().journal.emplace_back([table = table, primary = primary, old_secondary = old_secondary,
+                                       old_payer = old_payer, secondary] {
+        table->by_secondary.erase({ secondary, primary });
+        table->by_secondary.insert({ old_secondary, primary });
+        table->by_primary[primary] = { old_secondary, old_payer };
+    });
+
+    table->by_secondary.erase({ old_secondary, primary });
+    table->by_secondary.insert({ secondary, primary });
+    old_secondary = secondary;
+    old_payer = payer;
+
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(table->id.table), modifies, 1);
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(table->id.table), bytes_written, sizeof(Key));
+}
+
+template<typename Key>
+void SecondaryIndex<Key>::Remove(const int32_t iterator) {
+    const auto [table, primary] = GetIterator(iterator);
+
+    const auto [secondary, payer] = table->by_primary[primary];
+    Chain::Get().journal.emplace_back([table = table, primary = primary, secondary = secondary, payer = payer] {
+        table->by_primary[primary] = { secondary, payer };
+        table->by_secondary.insert({ secondary, primary });
+    });
+
+    table->by_secondary.erase({ secondary, primary });
+    table->by_primary.erase(primary);
+
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(table->id.table), erases, 1);
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::Next(const int32_t iterator, uint64_t* primary) {
+    if (iterator < -1) {
+        return -1;
+    }
+    const auto [table, current] = GetIterator(iterator);
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(table->id.table), iterations, 1);
+
+    const auto it = table->by_secondary.upper_bound({ table->by_primary[current].first, current });
+    return Found(*table, it, nullptr, primary);
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::Previous(const int32_t iterator, uint64_t* primary) {
+    if (iterator < -1) {
+        SecondaryTable<Key>& table = *tables.at(-(iterator + 2));
+        HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(table.id.table), iterations, 1);
+        if (table.by_secondary.empty()) {
+            return -1;
+        }
+        return Found(table, prev(table.by_secondary.end()), nullptr, primary);
+    }
+    const auto [table, current] = GetIterator(iterator);
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(table->id.table), iterations, 1);
+
+    const auto it = table->by_secondary.find({ table->by_primary[current].first, current });
+    if (it == table->by_secondary.begin()) {
+        return -1;
+    }
+    return Found(*table, prev(it), nullptr, primary);
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::FindPrimary(const TableId& id, Key* secondary, const uint64_t primary) {
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(id.table), finds, 1);
+
+    SecondaryTable<Key>* table = FindTable(id);
+    if (table == nullptr) {
+        return -1;
+    }
+
+    const auto entry_it = table->by_primary.find(primary);
+    if (entry_it == table->by_primary.end()) {
+        return GetEnd(*table);
+    }
+
+    *secondary = entry_it->second.first;
+    return AddIterator(*table, primary);
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::FindSecondary(const TableId& id, const Key* secondary, uint64_t* primary) {
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(id.table), finds, 1);
+
+    SecondaryTable<Key>* table = FindTable(id);
+    if (table == nullptr) {
+        return -1;
+    }
+
+    const auto it = table->by_secondary.lower_bound({ *secondary, 0 });
+    if (it == table->by_secondary.end() || it->first != *secondary) {
+        return GetEnd(*table);
+    }
+    return Found(*table, it, nullptr, primary);
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::LowerBound(const TableId& id, Key* secondary, uint64_t* primary) {
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(id.table), finds, 1);
+
+    SecondaryTable<Key>* table = FindTable(id);
+    if (table == nullptr) {
+        return -1;
+    }
+    return Found(*table, table->by_secondary.lower_bound({ *secondary, 0 }), secondary, primary);
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::UpperBound(const TableId& id, Key* secondary, uint64_t* primary) {
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(id.table), finds, 1);
+
+    SecondaryTable<Key>* table = FindTable(id);
+    if (table == nullptr) {
+        return -1;
+    }
+    return Found(*table, table->by_secondary.upper_bound({ *secondary, numeric_limits<uint64_t>::max() }),
+                 secondary, primary);
+}
+
+template<typename Key>
+int32_t SecondaryIndex<Key>::End(const TableId& id) {
+    HOST_COUNT(Chain::Get().metrics, GetSecondaryIndexId(id.table), finds, 1);
+
+    SecondaryTable<Key>* table = FindTable(id);
+    return table == nullptr ? -1 : GetEnd(*table);
+}
+
+template class SecondaryIndex<uint64_t>;
+template class SecondaryIndex<uint128_t>;
+template class SecondaryIndex<uint256_t>;
+
+}
+
+using host::Chain;
+using host::uint128_t;
+using host::uint256_t;
+
+// intrinsics imported by the contract, see eosio/action.hpp, eosio/multi_index.hpp and eosio/system.hpp
+extern "C" {
+
+void eosio_assert(const uint32_t test, const char* message) {
+    if (!test) {
+        throw host::AssertError(message);
+    }
+}
+
+void eosio_assert_message(const uint32_t test, const char* message, const uint32_t message_size) {
+    if (!test) {
+        throw host::AssertError(string(message, message_size));
+    }
+}
+
+void eosio_assert_code(const uint32_t test, const uint64_t code) {
+    if (!test) {
+        throw host::AssertError("assertion failure with error code: " + to_string(code));
+    }
+}
+
+void eosio_exit(int32_t) {
+    throw host::AssertError("eosio_exit is not supported");
+}
+
+void require_auth(const uint64_t actor) {
+    Chain::Intrinsic().RequireAuth(actor);
+}
+
+void require_auth2(const uint64_t actor, uint64_t) {
+    Chain::Intrinsic().RequireAuth(actor);
+}
+
+bool has_auth(const uint64_t actor) {
+    return Chain::Intrinsic().HasAuth(actor);
+}
+
+bool is_account(const uint64_t account) {
+    return Chain::Intrinsic().IsAccount(account);
+}
+
+void require_recipient(const uint64_t recipient) {
+    Chain::Intrinsic().RequireRecipient(recipient);
+}
+
+void send_inline(char* data, const size_t size) {
+    Chain::Intrinsic().SendInline(data, size);
+}
+
+uint64_t current_receiver() {
+    return Chain::Intrinsic().GetReceiver();
+}
+
+uint64_t current_time() {
+    return Chain::Intrinsic().GetTime();
+}
+
+void set_action_return_value(void*, size_t) {
+}
+
+void prints(const char* value) {
+    fputs(value, stdout);
+}
+
+void prints_l(const char* value, const uint32_t size) {
+    fwrite(value, 1, size, stdout);
+}
+
+void printi(const int64_t value) {
+    printf("%lld", static_cast<long long>(value));
+}
+
+void printui(const uint64_t value) {
+    printf("%llu", static_cast<unsigned long long>(value));
+}
+
+int32_t db_store_i64(const uint64_t scope, const uint64_t table, const uint64_t payer, const uint64_t id,
+                     const void* data, const uint32_t size) {
+    return Chain::Intrinsic().Store(scope, table, payer, id, data, size);
+}
+
+void db_update_i64(const int32_t iterator, const uint64_t payer, const void* data, const uint32_t size) {
+    Chain::Intrinsic().Update(iterator, payer, data, size);
+}
+
+void db_remove_i64(const int32_t iterator) {
+    Chain::Intrinsic().Remove(iterator);
+}
+
+int32_t db_get_i64(const int32_t iterator, void* data, const uint32_t size) {
+    return Chain::Intrinsic().GetRow(iterator, data, size);
+}
+
+int32_t db_next_i64(const int32_t iterator, uint64_t* primary) {
+    return Chain::Intrinsic().Next(iterator, primary);
+}
+
+int32_t db_previous_i64(const int32_t iterator, uint64_t* primary) {
+    return Chain::Intrinsic().Previous(iterator, primary);
+}
+
+int32_t db_find_i64(const uint64_t code, const uint64_t scope, const uint64_t table, const uint64_t id) {
+    return Chain::Intrinsic().Find(code, scope, table, id);
+}
+
+int32_t db_lowerbound_i64(const uint64_t code, const uint64_t scope, const uint64_t table, const uint64_t id) {
+    return Chain::Intrinsic().LowerBound(code, scope, table, id);
+}
+
+int32_t db_upperbound_i64(const uint64_t code, const uint64_t scope, const uint64_t table, const uint64_t id) {
+    return Chain::Intrinsic().UpperBound(code, scope, table, id);
+}
+
+int32_t db_end_i64(const uint64_t code, const uint64_t scope, const uint64_t table) {
+    return Chain::Intrinsic().End(code, scope, table);
+}
+
+#define HOST_SECONDARY_INDEX(IDX, TYPE)                                                                             \
+int32_t db_##IDX##_store(uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const TYPE* secondary) {      \
+    return Chain::Intrinsic().IDX.Store({ Chain::Intrinsic().GetReceiver(), scope, table }, payer, id, *secondary); \
+}                                                                                                                   \
+void db_##IDX##_update(int32_t iterator, uint64_t payer, const TYPE* secondary) {                                   \
+    Chain::Intrinsic().IDX.Update(iterator, payer, *secondary);                                                     \
+}                                                                                                                   \
+void db_##IDX##_remove(int32_t iterator) {                                                                          \
+    Chain::Intrinsic().IDX.Remove(iterator);                                                                        \
+}                                                                                                                   \
+int32_t db_##IDX##_next(int32_t iterator, uint64_t* primary) {                                                      \
+    return Chain::Intrinsic().IDX.Next(iterator, primary);                                                          \
+}                                                                                                                   \
+int32_t db_##IDX##_previous(int32_t iterator, uint64_t* primary) {                                                  \
+    return Chain::Intrinsic().IDX.Previous(iterator, primary);                                                      \
+}                                                                                                                   \
+int32_t db_##IDX##_find_primary(uint64_t code, uint64_t scope, uint64_t table, TYPE* secondary, uint64_t id) {      \
+    return Chain::Intrinsic().IDX.FindPrimary({ code, scope, table }, secondary, id);                               \
+}                                                                                                                   \
+int32_t db_##IDX##_find_secondary(uint64_t code, uint64_t scope, uint64_t table, const TYPE* secondary,             \
+                                  uint64_t* primary) {                                                              \
+    return Chain::Intrinsic().IDX.FindSecondary({ code, scope, table }, secondary, primary);                        \
+}                                                                                                                   \
+int32_t db_##IDX##_lowerbound(uint64_t code, uint64_t scope, uint64_t table, TYPE* secondary,                       \
+                              uint64_t* primary) {                                                                  \
+    return Chain::Intrinsic().IDX.LowerBound({ code, scope, table }, secondary, primary);                           \
+}                                                                                                                   \
+int32_t db_##IDX##_upperbound(uint64_t code, uint64_t scope, uint64_t table, TYPE* secondary,                       \
+                              uint64_t* primary) {                                                                  \
+    return Chain::Intrinsic().IDX.UpperBound({ code, scope, table }, secondary, primary);                           \
+}                                                                                                                   \
+int32_t db_##IDX##_end(uint64_t code, uint64_t scope, uint64_t table) {                                             \
+    return Chain::Intrinsic().IDX.End({ code, scope, table });                                                      \
+}
+
+HOST_SECONDARY_INDEX(idx64, uint64_t)
+HOST_SECONDARY_INDEX(idx128, uint128_t)
+
+#undef HOST_SECONDARY_INDEX
+
+// 256-bit keys are passed as two 128-bit words
+int32_t db_idx256_store(uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const uint128_t* secondary,
+                        uint32_t) {
+    return Chain::Intrinsic().idx256.Store({ Chain::Intrinsic().GetReceiver(), scope, table }, payer, id,
+                                     { secondary[0], secondary[1] });
+}
+
+void db_idx256_update(int32_t iterator, uint64_t payer, const uint128_t* secondary, uint32_t) {
+    Chain::Intrinsic().idx256.Update(iterator, payer, { secondary[0], secondary[1] });
+}
+
+void db_idx256_remove(int32_t iterator) {
+    Chain::Intrinsic().idx256.Remove(iterator);
+}
+
+int32_t db_idx256_next(int32_t iterator, uint64_t* primary) {
+    return Chain::Intrinsic().idx256.Next(iterator, primary);
+}
+
+int32_t db_idx256_previous(int32_t iterator, uint64_t* primary) {
+    return Chain::Intrinsic().idx256.Previous(iterator, primary);
+}
+
+int32_t db_idx256_find_primary(uint64_t code, uint64_t scope, uint64_t table, uint128_t* secondary, uint32_t,
+                               uint64_t id) {
+    uint256_t key {};
+    const int32_t iterator = Chain::Intrinsic().idx256.FindPrimary({ code, scope, table }, &key, id);
+    secondary[0] = key[0];
+    secondary[1] = key[1];
+    return iterator;
+}
+
+int32_t db_idx256_find_secondary(uint64_t code, uint64_t scope, uint64_t table, const uint128_t* secondary,
+                                 uint32_t, uint64_t* primary) {
+    const uint256_t key { secondary[0], secondary[1] };
+    return Chain::Intrinsic().idx256.FindSecondary({ code, scope, table }, &key, primary);
+}
+
+int32_t db_idx256_lowerbound(uint64_t code, uint64_t scope, uint64_t table, uint128_t* secondary, uint32_t,
+                             uint64_t* primary) {
+    uint256_t key { secondary[0], secondary[1] };
+    const int32_t iterator = Chain::Intrinsic().idx256.LowerBound({ code, scope, table }, &key, primary);
+    secondary[0] = key[0];
+    secondary[1] = key[1];
+    return iterator;
+}
+
+int32_t db_idx256_upperbound(uint64_t code, uint64_t scope, uint64_t table, uint128_t* secondary, uint32_t,
+                             uint64_t* primary) {
+    uint256_t key { secondary[0], secondary[1] };
+    const int32_t iterator = Chain::Intrinsic().idx256.UpperBound({ code, scope, table }, &key, primary);
+    secondary[0] = key[0];
+    secondary[1] = key[1];
+    return iterator;
+}
+
+int32_t db_idx256_end(uint64_t code, uint64_t scope, uint64_t table) {
+    return Chain::Intrinsic().idx256.End({ code, scope, table });
+}
+
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Metrics.hpp"
+
+// In-memory stand-in for the chain. It implements the intrinsics the contract imports
+// (database, authorization, inline actions), so the contract compiled natively with the
+// eosio.cdt headers runs without a node.
+namespace host {
+
+typedef unsigned __int128 uint128_t;
+typedef std::array<uint128_t, 2> uint256_t;
+
+// thrown by eosio::check and by failed authorization, the action is reverted
+class AssertError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct TableId {
+    uint64_t code = 0;
+    uint64_t scope = 0;
+    uint64_t table = 0;
+
+    auto operator<=>(const TableId&) const = default;
+};
+
+struct Row {
+    uint64_t payer = 0;
+    std::vector<char> data;
+};
+
+struct PrimaryTable {
+    TableId id;
+    std::map<uint64_t, Row> rows;
+};
+
+template<typename Key>
+struct SecondaryTable {
+    TableId id;
+    std::map<uint64_t, std::pair<Key, uint64_t>> by_primary; // primary -> (secondary, payer)
+    std::set<std::pair<Key, uint64_t>> by_secondary;
+};
+
+template<typename Key>
+class SecondaryIndex {
+public:
+    int32_t Store(const TableId& id, uint64_t payer, uint64_t primary, const Key& secondary);
+    void Update(int32_t iterator, uint64_t payer, const Key& secondary);
+    void Remove(int32_t iterator);
+    int32_t Next(int32_t iterator, uint64_t* primary);
+    int32_t Previous(int32_t iterator, uint64_t* primary);
+    int32_t FindPrimary(const TableId& id, Key* secondary, uint64_t primary);
+    int32_t FindSecondary(const TableId& id, const Key* secondary, uint64_t* primary);
+    int32_t LowerBound(const TableId& id, Key* secondary, uint64_t* primary);
+    int32_t UpperBound(const TableId& id, Key* secondary, uint64_t* primary);
+    int32_t End(const TableId& id);
+
+    void ClearIterators() { iterators.clear(); }
+
+private:
+    SecondaryTable<Key>* FindTable(const TableId& id);
+    SecondaryTable<Key>& GetTable(const TableId& id);
+    int32_t GetEnd(const SecondaryTable<Key>& table) const;
+    int32_t AddIterator(SecondaryTable<Key>& table, uint64_t primary);
+    std::pair<SecondaryTable<Key>*, uint64_t> GetIterator(int32_t iterator);
+    int32_t Found(SecondaryTable<Key>& table, typename std::set<std::pair<Key, uint64_t>>::const_iterator it,
+                  Key* secondary, uint64_t* primary);
+
+    std::map<TableId, size_t> table_index;
+    std::vector<std::unique_ptr<SecondaryTable<Key>>> tables;
+    std::vector<std::pair<SecondaryTable<Key>*, uint64_t>> iterators;
+
+    friend class Chain;
+};
+
+class Chain {
+public:
+    static Chain& Get();
+    // the same chain for intrinsics, allocations made by the chain itself are not counted as the contract ones
+    static Chain& Intrinsic(const IntrinsicScope& scope = {});
+
+    // accounts known to is_account
+    void AddAccount(uint64_t account);
+    [[nodiscard]] bool IsAccount(uint64_t account) const;
+
+    // starts an action of "receiver" authorized by "auths"
+    void BeginAction(uint64_t receiver, std::vector<uint64_t> auths);
+    // keeps the changes of the current action
+    void CommitAction();
+    // undoes every database change of the current action
+    void RevertAction();
+
+    // runs "action" as one action, returns false if it was reverted; the message is kept in "error"
+    bool Run(uint64_t receiver, std::vector<uint64_t> auths, const std::function<void()>& action,
+             std::string* error = nullptr);
+
+    [[nodiscard]] uint64_t GetReceiver() const { return receiver; }
+    [[nodiscard]] bool HasAuth(uint64_t actor) const;
+    void RequireAuth(uint64_t actor) const;
+    void RequireRecipient(uint64_t recipient);
+    void SendInline(const char* data, size_t size);
+
+    void SetTime(uint64_t microseconds) { time = microseconds; }
+    [[nodiscard]] uint64_t GetTime() const { return time; }
+
+    // resources used by the last action, counted only with DEX_INSTRUMENTATION
+    [[nodiscard]] const ActionMetrics& GetMetrics() const { return metrics; }
+    // prints the metrics of every action to stderr
+    void SetPrintMetrics(bool enabled) { print_metrics = enabled; }
+
+    // packed eosio::action and notified accounts of the last action
+    [[nodiscard]] const std::vector<std::vector<char>>& GetInlineActions() const { return inline_actions; }
+    [[nodiscard]] const std::vector<uint64_t>& GetRecipients() const { return recipients; }
+
+    // database, same semantics as the db_*_i64 intrinsics
+    int32_t Store(uint64_t scope, uint64_t table, uint64_t payer, uint64_t primary, const void* data, uint32_t size);
+    void Update(int32_t iterator, uint64_t payer, const void* data, uint32_t size);
+    void Remove(int32_t iterator);
+    int32_t GetRow(int32_t iterator, void* data, uint32_t size);
+    int32_t Next(int32_t iterator, uint64_t* primary);
+    int32_t Previous(int32_t iterator, uint64_t* primary);
+    int32_t Find(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary);
+    int32_t LowerBound(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary);
+    int32_t UpperBound(uint64_t code, uint64_t scope, uint64_t table, uint64_t primary);
+    int32_t End(uint64_t code, uint64_t scope, uint64_t table);
+
+    SecondaryIndex<uint64_t> idx64;
+    SecondaryIndex<uint128_t> idx128;
+    SecondaryIndex<uint256_t> idx256;
+
+    // all rows of a table in every scope, for snapshots and tools
+    void ForEachRow(uint64_t code, uint64_t table,
+                    const std::function<void(uint64_t scope, uint64_t primary, const Row& row)>& callback) const;
+
+    // drops all tables, accounts and the journal
+    void Reset();
+
+    // undo log and metrics of the current action
+    std::vector<std::function<void()>> journal;
+    ActionMetrics metrics;
+
+private:
+    PrimaryTable* FindTable(const TableId& id);
+    PrimaryTable& GetTable(const TableId& id);
+    int32_t GetEnd(const PrimaryTable& table) const;
+    int32_t AddIterator(PrimaryTable& table, uint64_t primary);
+    std::pair<PrimaryTable*, uint64_t> GetIterator(int32_t iterator);
+
+    std::map<TableId, size_t> table_index;
+    std::vector<std::unique_ptr<PrimaryTable>> tables;
+    std::vector<std::pair<PrimaryTable*, uint64_t>> iterators;
+
+    std::set<uint64_t> accounts;
+    std::vector<uint64_t> auths;
+    uint64_t receiver = 0;
+    uint64_t time = 0;
+    bool print_metrics = false;
+
+    std::vector<std::vector<char>> inline_actions;
+    std::vector<uint64_t> recipients;
+};
+
+}
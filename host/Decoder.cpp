@@ -0,0 +1,269 @@
+#include "Decoder.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std;
+using namespace eosio;
+
+namespace host {
+
+namespace {
+
+// bounds checked reads of the state history serialization, nothing is copied out of the input
+class Reader {
+public:
+    Reader(const char* data, const size_t size) : position(data), end(data + size) {}
+
+    [[nodiscard]] bool Empty() const { return position == end; }
+
+    uint8_t ReadByte() {
+        Need(1);
+        return uint8_t(*position++);
+    }
+
+    uint32_t ReadUInt32() {
+        Need(sizeof(uint32_t));
+        uint32_t value = 0;
+        memcpy(&value, position, sizeof(uint32_t));
+        position += sizeof(uint32_t);
+        return value;
+    }
+
+    uint64_t ReadUInt64() {
+        Need(sizeof(uint64_t));
+        uint64_t value = 0;
+        memcpy(&value, position, sizeof(uint64_t));
+        position += sizeof(uint64_t);
+        return value;
+    }
+
+    uint32_t ReadVarUInt32() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            const uint8_t byte = ReadByte();
+            value |= uint32_t(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw runtime_error("invalid varuint32");
+    }
+
+    // string or bytes, points into the input
+    string_view ReadBytes() {
+        return ReadFixed(ReadVarUInt32());
+    }
+
+    string_view ReadFixed(const size_t size) {
+        Need(size);
+        const string_view value { position, size };
+        position += size;
+        return value;
+    }
+
+private:
+    void Need(const size_t size) const {
+        if (size_t(end - position) < size) {
+            throw runtime_error("truncated deltas");
+        }
+    }
+
+    const char* position;
+    const char* end;
+};
+
+// columns are written as: uint8_t name size, name, uint8_t value size, uint8_t kind (0 unsigned, 1 signed),
+// uint64_t row count, values in host byte order
+template<typename T>
+void WriteColumn(ofstream& output, const string_view column, const vector<T>& values) {
+    const uint8_t name_size = column.size();
+    const uint8_t value_size = sizeof(T);
+    const uint8_t kind = is_signed_v<T> ? 1 : 0;
+    const uint64_t count = values.size();
+
+    output.write(reinterpret_cast<const char*>(&name_size), sizeof(name_size));
+    output.write(column.data(), name_size);
+    output.write(reinterpret_cast<const char*>(&value_size), sizeof(value_size));
+    output.write(reinterpret_cast<const char*>(&kind), sizeof(kind));
+    output.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    output.write(reinterpret_cast<const char*>(values.data()), streamsize(count * sizeof(T)));
+}
+
+constexpr char COLUMNS_MAGIC[8] = { 'D', 'E', 'X', 'C', 'O', 'L', 'S', '1' };
+constexpr uint32_t COLUMNS_COUNT = 28;
+
+}
+
+void TableDecoder::DecodeRow(const name table, const uint64_t scope, const bool present, const char* data,
+                             const size_t size) {
+    datastream<const char*> ds { data, size };
+
+    if (table == "stat"_n) {
+        Contract::CurrencyStatRecord record;
+        ds >> record;
+
+        pairs.sequence.push_back(sequence);
+        pairs.scope.push_back(scope);
+        pairs.present.push_back(present);
+        pairs.supply.push_back(record.supply.amount);
+        pairs.supply_symbol.push_back(record.supply.symbol.raw());
+        pairs.pool1.push_back(record.pool1.quantity.amount);
+        pairs.pool1_symbol.push_back(record.pool1.quantity.symbol.raw());
+        pairs.pool1_contract.push_back(record.pool1.contract.value);
+        pairs.pool2.push_back(record.pool2.quantity.amount);
+        pairs.pool2_symbol.push_back(record.pool2.quantity.symbol.raw());
+        pairs.pool2_contract.push_back(record.pool2.contract.value);
+        pairs.raw_pool1.push_back(record.raw_pool1_amount);
+        pairs.raw_pool2.push_back(record.raw_pool2_amount);
+        pairs.fee.push_back(record.fee);
+        pairs.last_update.push_back(record.last_update);
+    } else if (table == "accounts"_n) {
+        Contract::BalanceRecord record;
+        ds >> record;
+
+        balances.sequence.push_back(sequence);
+        balances.scope.push_back(scope);
+        balances.present.push_back(present);
+        balances.amount.push_back(record.balance.amount);
+        balances.symbol.push_back(record.balance.symbol.raw());
+    } else if (table == "depositsv2"_n || table == "deposits"_n) {
+        uint64_t primary = 0;
+        extended_asset balance;
+        if (table == "depositsv2"_n) {
+            Contract::DepositRecord record;
+            ds >> record;
+            primary = record.key;
+            balance = record.balance;
+        } else {
+            Contract::LegacyDepositRecord record;
+            ds >> record;
+            primary = record.id;
+            balance = record.balance;
+        }
+
+        deposits.sequence.push_back(sequence);
+        deposits.scope.push_back(scope);
+        deposits.present.push_back(present);
+        deposits.legacy.push_back(table == "deposits"_n);
+        deposits.primary.push_back(primary);
+        deposits.amount.push_back(balance.quantity.amount);
+        deposits.symbol.push_back(balance.quantity.symbol.raw());
+        deposits.contract.push_back(balance.contract.value);
+    } else {
+        skipped++;
+        return;
+    }
+    decoded++;
+}
+
+void TableDecoder::DecodeDeltas(const char* data, const size_t size) {
+    Reader reader { data, size };
+
+    const uint32_t delta_count = reader.ReadVarUInt32();
+    for (uint32_t i = 0; i < delta_count; i++) {
+        // table_delta_v0 and table_delta_v1 share the layout
+        if (reader.ReadVarUInt32() > 1) {
+            throw runtime_error("unknown table_delta version");
+        }
+        const bool is_contract_row = reader.ReadBytes() == "contract_row";
+
+        const uint32_t row_count = reader.ReadVarUInt32();
+        for (uint32_t j = 0; j < row_count; j++) {
+            const bool present = reader.ReadByte() != 0;
+            const string_view row = reader.ReadBytes();
+            if (!is_contract_row) {
+                skipped++;
+                continue;
+            }
+
+            Reader row_reader { row.data(), row.size() };
+            if (row_reader.ReadVarUInt32() != 0) {
+                throw runtime_error("unknown contract_row version");
+            }
+            const uint64_t code = row_reader.ReadUInt64();
+            const uint64_t scope = row_reader.ReadUInt64();
+            const uint64_t table = row_reader.ReadUInt64();
+            row_reader.ReadUInt64(); // primary key
+            row_reader.ReadUInt64(); // payer
+            const string_view value = row_reader.ReadBytes();
+
+            if (code != contract.value) {
+                skipped++;
+                continue;
+            }
+            DecodeRow(name { table }, scope, present, value.data(), value.size());
+        }
+    }
+}
+
+void TableDecoder::DecodeDeltaFile(const char* data, const size_t size) {
+    Reader reader { data, size };
+    while (!reader.Empty()) {
+        const string_view block = reader.ReadFixed(reader.ReadUInt32());
+        DecodeDeltas(block.data(), block.size());
+        sequence++;
+    }
+}
+
+bool TableDecoder::WriteColumns(const string& path) const {
+    ofstream output { path, ios::binary };
+    output.write(COLUMNS_MAGIC, sizeof(COLUMNS_MAGIC));
+    output.write(reinterpret_cast<const char*>(&COLUMNS_COUNT), sizeof(COLUMNS_COUNT));
+
+    WriteColumn(output, "stat.sequence", pairs.sequence);
+    WriteColumn(output, "stat.scope", pairs.scope);
+    WriteColumn(output, "stat.present", pairs.present);
+    WriteColumn(output, "stat.supply", pairs.supply);
+    WriteColumn(output, "stat.supply_symbol", pairs.supply_symbol);
+    WriteColumn(output, "stat.pool1", pairs.pool1);
+    WriteColumn(output, "stat.pool1_symbol", pairs.pool1_symbol);
+    WriteColumn(output, "stat.pool1_contract", pairs.pool1_contract);
+    WriteColumn(output, "stat.pool2", pairs.pool2);
+    WriteColumn(output, "stat.pool2_symbol", pairs.pool2_symbol);
+    WriteColumn(output, "stat.pool2_contract", pairs.pool2_contract);
+    WriteColumn(output, "stat.raw_pool1", pairs.raw_pool1);
+    WriteColumn(output, "stat.raw_pool2", pairs.raw_pool2);
+    WriteColumn(output, "stat.fee", pairs.fee);
+    WriteColumn(output, "stat.last_update", pairs.last_update);
+
+    WriteColumn(output, "accounts.sequence", balances.sequence);
+    WriteColumn(output, "accounts.scope", balances.scope);
+    WriteColumn(output, "accounts.present", balances.present);
+    WriteColumn(output, "accounts.amount", balances.amount);
+    WriteColumn(output, "accounts.symbol", balances.symbol);
+
+    WriteColumn(output, "deposits.sequence", deposits.sequence);
+    WriteColumn(output, "deposits.scope", deposits.scope);
+    WriteColumn(output, "deposits.present", deposits.present);
+    WriteColumn(output, "deposits.legacy", deposits.legacy);
+    WriteColumn(output, "deposits.primary", deposits.primary);
+    WriteColumn(output, "deposits.amount", deposits.amount);
+    WriteColumn(output, "deposits.symbol", deposits.symbol);
+    WriteColumn(output, "deposits.contract", deposits.contract);
+    return bool(output);
+}
+
+vector<char> TableDecoder::EncodePair(const asset& supply, const extended_asset& pool1, const extended_asset& pool2,
+                                      const int64_t raw_pool1, const int64_t raw_pool2, const int fee) {
+    Contract::CurrencyStatRecord record;
+    record.supply = supply;
+    record.pool1 = pool1;
+    record.pool2 = pool2;
+    record.raw_pool1_amount = raw_pool1;
+    record.raw_pool2_amount = raw_pool2;
+    record.fee = fee;
+    return pack(record);
+}
+
+vector<char> TableDecoder::EncodeBalance(const asset& balance) {
+    return pack(Contract::BalanceRecord { balance });
+}
+
+vector<char> TableDecoder::EncodeDeposit(const uint64_t key, const extended_asset& balance) {
+    return pack(Contract::DepositRecord { key, balance });
+}
+
+}
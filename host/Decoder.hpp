@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Contract.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Decodes "stat", "accounts", "depositsv2" and "deposits" rows of the contract with the contract's own records
+// straight from the input buffer, into one column per field. Rows of other tables and contracts are counted and
+// skipped.
+namespace host {
+
+// one entry per decoded row; "sequence" is the block of a delta file (0 for a snapshot),
+// "present" is 0 for a removed row, its last value is still decoded
+struct PairColumns {
+    std::vector<uint64_t> sequence;
+    std::vector<uint64_t> scope;
+    std::vector<uint8_t> present;
+    std::vector<int64_t> supply;
+    std::vector<uint64_t> supply_symbol;
+    std::vector<int64_t> pool1;
+    std::vector<uint64_t> pool1_symbol;
+    std::vector<uint64_t> pool1_contract;
+    std::vector<int64_t> pool2;
+    std::vector<uint64_t> pool2_symbol;
+    std::vector<uint64_t> pool2_contract;
+    std::vector<int64_t> raw_pool1;
+    std::vector<int64_t> raw_pool2;
+    std::vector<int64_t> fee;
+    std::vector<uint32_t> last_update;
+};
+
+struct BalanceColumns {
+    std::vector<uint64_t> sequence;
+    std::vector<uint64_t> scope;
+    std::vector<uint8_t> present;
+    std::vector<int64_t> amount;
+    std::vector<uint64_t> symbol;
+};
+
+// rows of "depositsv2" and of the legacy "deposits" ("legacy" is 1)
+struct DepositColumns {
+    std::vector<uint64_t> sequence;
+    std::vector<uint64_t> scope;
+    std::vector<uint8_t> present;
+    std::vector<uint8_t> legacy;
+    std::vector<uint64_t> primary;
+    std::vector<int64_t> amount;
+    std::vector<uint64_t> symbol;
+    std::vector<uint64_t> contract;
+};
+
+class TableDecoder {
+public:
+    explicit TableDecoder(eosio::name contract) : contract(contract) {}
+
+    // one row of the contract; throws AssertError if it does not decode
+    void DecodeRow(eosio::name table, uint64_t scope, bool present, const char* data, size_t size);
+
+    // serialized vector<table_delta> of one block as sent by the state history plugin after decompression;
+    // "contract_row" deltas are decoded, the others are skipped; throws std::runtime_error on truncated input
+    void DecodeDeltas(const char* data, size_t size);
+    // blocks of a delta file, every block is prefixed with its uint32_t size and gets the next sequence number
+    void DecodeDeltaFile(const char* data, size_t size);
+
+    // writes the columns to "path", see the format in Decoder.cpp
+    bool WriteColumns(const std::string& path) const;
+
+    [[nodiscard]] const PairColumns& GetPairs() const { return pairs; }
+    [[nodiscard]] const BalanceColumns& GetBalances() const { return balances; }
+    [[nodiscard]] const DepositColumns& GetDeposits() const { return deposits; }
+    [[nodiscard]] uint64_t GetDecoded() const { return decoded; }
+    [[nodiscard]] uint64_t GetSkipped() const { return skipped; }
+
+    // bytes of one row as stored by the contract, for fixtures and tests
+    static std::vector<char> EncodePair(const eosio::asset& supply, const eosio::extended_asset& pool1,
+                                        const eosio::extended_asset& pool2, int64_t raw_pool1, int64_t raw_pool2,
+                                        int fee);
+    static std::vector<char> EncodeBalance(const eosio::asset& balance);
+    static std::vector<char> EncodeDeposit(uint64_t key, const eosio::extended_asset& balance);
+
+private:
+    eosio::name contract;
+    uint64_t sequence = 0;
+    uint64_t decoded = 0;
+    uint64_t skipped = 0;
+
+    PairColumns pairs;
+    BalanceColumns balances;
+    DepositColumns deposits;
+};
+
+}
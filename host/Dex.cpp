@@ -0,0 +1,133 @@
+#include "Dex.hpp"
+
+using namespace std;
+using namespace eosio;
+
+namespace host {
+
+Dex::Dex(const name self) : self(self) {
+    Chain::Get().AddAccount(self.value);
+}
+
+bool Dex::Deposit(const name token_contract, const name from, const asset quantity, const string& memo,
+                  string* error) {
+    return Chain::Get().Run(self.value, {}, [&] {
+        Contract contract { self, token_contract, datastream<const char*> { nullptr, 0 } };
+        contract.OnTokenDeposit(from, self, quantity, memo);
+    }, error);
+}
+
+vector<Transfer> Dex::GetTransfers() const {
+    vector<Transfer> transfers;
+
+    for (const vector<char>& packed : Chain::Get().GetInlineActions()) {
+        const action inline_action = unpack<action>(packed);
+        if (inline_action.name != "transfer"_n) {
+            continue;
+        }
+
+        const auto [from, to, quantity, memo] = unpack<tuple<name, name, asset, string>>(inline_action.data);
+        transfers.push_back({ inline_action.account, from, to, quantity, memo });
+    }
+
+    return transfers;
+}
+
+optional<Contract::CurrencyStatRecord> Dex::GetPair(const symbol_code pair_code) const {
+    const Contract::CurrencyStatsTable stats_table { self, pair_code.raw() };
+
+    const auto token_it = stats_table.find(pair_code.raw());
+    if (token_it == stats_table.end()) {
+        return nullopt;
+    }
+    return *token_it;
+}
+
+asset Dex::GetBalance(const name user, const symbol token) const {
+    const Contract::BalancesTable balances { self, user.value };
+
+    const auto balance_it = balances.find(token.code().raw());
+    return balance_it == balances.end() ? asset { 0, token } : balance_it->balance;
+}
+
+extended_asset Dex::GetDeposit(const name user, const extended_symbol token) const {
+    const Contract::DepositsTable deposits { self, user.value };
+
+    const auto deposit_it = Contract::FindByToken(deposits, token);
+    return deposit_it == deposits.end() ? extended_asset { 0, token } : deposit_it->balance;
+}
+
+extended_asset Dex::GetFee(const name collector, const extended_symbol token) const {
+    const Contract::FeesTable fees { self, collector.value };
+
+    const auto fee_it = Contract::FindByToken(fees, token);
+    return fee_it == fees.end() ? extended_asset { 0, token } : fee_it->balance;
+}
+
+const vector<name> Dex::TABLES {
+    "stat"_n, "observations"_n, "volumes"_n, "accounts"_n, "depositsv2"_n, "deposits"_n, "pairs"_n, "fees"_n,
+    "tokens"_n
+};
+
+bool Dex::LoadRows(const vector<SnapshotRow>& rows, string* error) {
+    return Chain::Get().Run(self.value, {}, [&] {
+        for (const SnapshotRow& row : rows) {
+            if (row.table == "stat"_n) {
+                LoadRow<Contract::CurrencyStatsTable, Contract::CurrencyStatRecord>(row);
+            } else if (row.table == "observations"_n) {
+                LoadRow<Contract::ObservationsTable, Contract::ObservationRecord>(row);
+            } else if (row.table == "volumes"_n) {
+                LoadRow<Contract::VolumesTable, Contract::VolumeRecord>(row);
+            } else if (row.table == "accounts"_n) {
+                LoadRow<Contract::BalancesTable, Contract::BalanceRecord>(row);
+            } else if (row.table == "depositsv2"_n) {
+                LoadRow<Contract::DepositsTable, Contract::DepositRecord>(row);
+            } else if (row.table == "deposits"_n) {
+                LoadRow<Contract::LegacyDepositsTable, Contract::LegacyDepositRecord>(row);
+            } else if (row.table == "pairs"_n) {
+                LoadRow<Contract::PairsTable, Contract::PairRecord>(row);
+            } else if (row.table == "fees"_n) {
+                LoadRow<Contract::FeesTable, Contract::FeeRecord>(row);
+            } else if (row.table == "tokens"_n) {
+                LoadRow<Contract::TokensTable, Contract::TokenRecord>(row);
+            } else {
+                check(false, "unknown table " + row.table.to_string());
+            }
+        }
+    }, error);
+}
+
+template<typename Table, typename Record>
+void Dex::LoadRow(const SnapshotRow& row) const {
+    const Record record = unpack<Record>(row.data);
+
+    Table table { self, row.scope };
+    table.emplace(row.payer, [&](Record& value) {
+        value = record;
+    });
+}
+
+vector<SnapshotRow> Dex::GetRows() const {
+    vector<SnapshotRow> rows;
+    for (const name& table : TABLES) {
+        Chain::Get().ForEachRow(self.value, table.value, [&](const uint64_t scope, uint64_t, const Row& row) {
+            rows.push_back({ table, scope, name { row.payer }, row.data });
+        });
+    }
+    return rows;
+}
+
+Contract::CurrencyStatRecord Dex::DecodePair(const vector<char>& data) {
+    return unpack<Contract::CurrencyStatRecord>(data);
+}
+
+vector<uint64_t> Dex::ToRaw(const vector<name>& names) {
+    vector<uint64_t> result;
+    result.reserve(names.size());
+    for (const name& value : names) {
+        result.push_back(value.value);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Contract.hpp>
+#include "Chain.hpp"
+
+#include <optional>
+
+namespace host {
+
+// token transfer sent inline by the contract
+struct Transfer {
+    eosio::name contract;
+    eosio::name from;
+    eosio::name to;
+    eosio::asset quantity;
+    std::string memo;
+};
+
+// raw row of a contract table, as returned by get_table_rows without "json"
+struct SnapshotRow {
+    eosio::name table;
+    uint64_t scope = 0;
+    eosio::name payer;
+    std::vector<char> data;
+};
+
+// runs the contract deployed to "self" on the in-memory chain
+class Dex {
+public:
+    explicit Dex(eosio::name self);
+
+    // calls "action" with the contract as one action authorized by "auths", false if it was reverted
+    template<typename Action>
+    bool Run(const std::vector<eosio::name>& auths, Action&& action, std::string* error = nullptr) {
+        return Chain::Get().Run(self.value, ToRaw(auths), [&] {
+            Contract contract { self, self, eosio::datastream<const char*> { nullptr, 0 } };
+            action(contract);
+        }, error);
+    }
+
+    // "token_contract::transfer" notification from "from" to the contract
+    bool Deposit(eosio::name token_contract, eosio::name from, eosio::asset quantity, const std::string& memo = "",
+                 std::string* error = nullptr);
+
+    // token transfers sent inline by the last action
+    [[nodiscard]] std::vector<Transfer> GetTransfers() const;
+
+    [[nodiscard]] std::optional<Contract::CurrencyStatRecord> GetPair(eosio::symbol_code pair_code) const;
+    [[nodiscard]] eosio::asset GetBalance(eosio::name user, eosio::symbol token) const;
+    [[nodiscard]] eosio::extended_asset GetDeposit(eosio::name user, eosio::extended_symbol token) const;
+    // fees accrued to "collector" and not claimed yet
+    [[nodiscard]] eosio::extended_asset GetFee(eosio::name collector, eosio::extended_symbol token) const;
+
+    // resources used by the last action
+    [[nodiscard]] const ActionMetrics& GetMetrics() const { return Chain::Get().GetMetrics(); }
+
+    [[nodiscard]] eosio::name GetSelf() const { return self; }
+
+    // stores the rows through the contract tables, so secondary indexes are built as on chain;
+    // false if a row does not decode or its table is unknown
+    bool LoadRows(const std::vector<SnapshotRow>& rows, std::string* error = nullptr);
+    // rows of every contract table, ordered by table, scope and primary key
+    [[nodiscard]] std::vector<SnapshotRow> GetRows() const;
+
+    // "stat" row, rows in the layout before v2 included
+    [[nodiscard]] static Contract::CurrencyStatRecord DecodePair(const std::vector<char>& data);
+
+    // tables of the contract, secondary indexes excluded
+    static const std::vector<eosio::name> TABLES;
+
+private:
+    static std::vector<uint64_t> ToRaw(const std::vector<eosio::name>& names);
+
+    template<typename Table, typename Record>
+    void LoadRow(const SnapshotRow& row) const;
+
+    eosio::name self;
+};
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Dex.hpp"
+#include <Util.hpp>
+
+#include <cstdio>
+#include <string>
+
+// accounts, pair parameters and helpers shared by the host tests and the benchmark
+namespace host::fixture {
+
+const eosio::name SELF = "agora.dex"_n;
+const eosio::name TOKEN_CONTRACT = "eosio.token"_n;
+const eosio::name ISSUER = "issuer"_n;
+const eosio::name FEE_COLLECTOR = "fees"_n;
+
+const int PAIR_FEE = 300000;               // 0.3%
+const int FEE_COLLECTOR_RATE = 50000000;   // half of the fee
+
+const eosio::symbol_code PAIR_CODE { "LPAB" };
+const eosio::symbol PAIR_TOKEN { PAIR_CODE, 4 };
+
+// number of failed Expect checks, a test exits with 1 if it is not zero
+inline uint32_t failures = 0;
+
+inline void Expect(const bool condition, const std::string& what) {
+    if (!condition) {
+        printf("failed: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+// "amount" of the token "code" of TOKEN_CONTRACT with precision 4
+inline eosio::extended_asset Token(const char* code, const int64_t amount) {
+    return { eosio::asset { amount, eosio::symbol { eosio::symbol_code { code }, 4 } }, TOKEN_CONTRACT };
+}
+
+// allows both tokens, deposits the pools to the issuer and creates the pair, false if one of the actions failed
+inline bool CreatePair(Dex& dex, const eosio::extended_asset& pool1, const eosio::extended_asset& pool2,
+                       const eosio::symbol_code code = PAIR_CODE, std::string* error = nullptr) {
+    for (const eosio::extended_asset& pool : { pool1, pool2 }) {
+        const bool allowed = dex.Run({ SELF }, [&](Contract& contract) {
+            contract.AllowToken(pool.get_extended_symbol(), true);
+        }, error);
+        if (!allowed || !dex.Deposit(pool.contract, ISSUER, pool.quantity, "", error)) {
+            return false;
+        }
+    }
+
+    return dex.Run({ SELF, ISSUER }, [&](Contract& contract) {
+        contract.CreatePair(ISSUER, code, pool1, pool2, PAIR_FEE, FEE_COLLECTOR, FEE_COLLECTOR_RATE);
+    }, error);
+}
+
+// deposits both assets of "user" and adds as much of them as they pay with the add liquidity fee, false if one of
+// the actions failed; the initial supply is the min liquidity of a pair, so nothing can be swapped out of a new
+// pair before liquidity is added
+inline bool AddLiquidity(Dex& dex, const eosio::name user, const eosio::extended_asset& asset1,
+                         const eosio::extended_asset& asset2, const eosio::symbol token = PAIR_TOKEN,
+                         std::string* error = nullptr) {
+    for (const eosio::extended_asset& value : { asset1, asset2 }) {
+        if (!dex.Deposit(value.contract, user, value.quantity, "", error)) {
+            return false;
+        }
+    }
+
+    const eosio::extended_asset max_asset1 {
+        CalculateAmountWithoutFee(asset1.quantity.amount, ADD_LIQUIDITY_FEE), asset1.get_extended_symbol()
+    };
+    const eosio::extended_asset max_asset2 {
+        CalculateAmountWithoutFee(asset2.quantity.amount, ADD_LIQUIDITY_FEE), asset2.get_extended_symbol()
+    };
+    return dex.Run({ user }, [&](Contract& contract) {
+        contract.AddLiquidity(user, token, max_asset1, max_asset2, {});
+    }, error);
+}
+
+}
@@ -0,0 +1,128 @@
+#include "Metrics.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+using namespace std;
+
+namespace host {
+
+OperationCounters& OperationCounters::operator+=(const OperationCounters& other) {
+    finds += other.finds;
+    iterations += other.iterations;
+    reads += other.reads;
+    emplaces += other.emplaces;
+    modifies += other.modifies;
+    erases += other.erases;
+    bytes_read += other.bytes_read;
+    bytes_written += other.bytes_written;
+    return *this;
+}
+
+OperationCounters ActionMetrics::Total() const {
+    OperationCounters total;
+    for (const auto& [id, counters] : indexes) {
+        total += counters;
+    }
+    return total;
+}
+
+OperationCounters ActionMetrics::OfTable(const string& table) const {
+    OperationCounters total;
+    for (const auto& [id, counters] : indexes) {
+        if (NameToString(id.first) == table) {
+            total += counters;
+        }
+    }
+    return total;
+}
+
+string ActionMetrics::ToString() const {
+    ostringstream out;
+    for (const auto& [id, counters] : indexes) {
+        out << NameToString(id.first);
+        if (id.second >= 0) {
+            out << "/" << id.second;
+        }
+        out << ": find " << counters.finds << ", next " << counters.iterations << ", read " << counters.reads
+            << ", emplace " << counters.emplaces << ", modify " << counters.modifies << ", erase " << counters.erases
+            << ", bytes read " << counters.bytes_read << ", bytes written " << counters.bytes_written << "\n";
+    }
+    out << "inline actions: " << inline_actions << " (" << inline_action_bytes << " bytes)\n";
+    out << "allocations: " << allocations << " (" << allocated_bytes << " bytes)\n";
+    return out.str();
+}
+
+ActionMetrics& ActionMetrics::operator+=(const ActionMetrics& other) {
+    for (const auto& [id, counters] : other.indexes) {
+        indexes[id] += counters;
+    }
+    inline_actions += other.inline_actions;
+    inline_action_bytes += other.inline_action_bytes;
+    allocations += other.allocations;
+    allocated_bytes += other.allocated_bytes;
+    return *this;
+}
+
+string NameToString(const uint64_t value) {
+    static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+
+    string result(13, '.');
+    uint64_t rest = value;
+    for (uint32_t i = 0; i <= 12; i++) {
+        result[12 - i] = charmap[rest & (i == 0 ? 0x0f : 0x1f)];
+        rest >>= (i == 0 ? 4 : 5);
+    }
+
+    const size_t last = result.find_last_not_of('.');
+    return last == string::npos ? string {} : result.substr(0, last + 1);
+}
+
+IndexId GetSecondaryIndexId(const uint64_t table) {
+    return { table & 0xFFFFFFFFFFFFFFF0ULL, static_cast<int32_t>(table & 0x0F) };
+}
+
+namespace {
+    thread_local ActionMetrics* counted_metrics = nullptr;
+    thread_local uint32_t intrinsic_depth = 0;
+}
+
+void SetAllocationCounting(const bool enabled, ActionMetrics* metrics) {
+    counted_metrics = enabled ? metrics : nullptr;
+}
+
+IntrinsicScope::IntrinsicScope() {
+    intrinsic_depth++;
+}
+
+IntrinsicScope::~IntrinsicScope() {
+    intrinsic_depth--;
+}
+
+}
+
+#ifdef DEX_INSTRUMENTATION
+
+void* operator new(const size_t size) {
+    if (host::counted_metrics != nullptr && host::intrinsic_depth == 0) {
+        host::counted_metrics->allocations++;
+        host::counted_metrics->allocated_bytes += size;
+    }
+
+    void* result = malloc(size == 0 ? 1 : size);
+    if (result == nullptr) {
+        throw bad_alloc();
+    }
+    return result;
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+// Resource counters of one action, collected by the host chain when built with DEX_INSTRUMENTATION.
+namespace host {
+
+struct OperationCounters {
+    uint64_t finds = 0;         // find, lower_bound, upper_bound and end
+    uint64_t iterations = 0;    // next and previous
+    uint64_t reads = 0;         // rows loaded
+    uint64_t emplaces = 0;
+    uint64_t modifies = 0;
+    uint64_t erases = 0;
+    uint64_t bytes_read = 0;    // deserialized rows and secondary keys
+    uint64_t bytes_written = 0; // serialized rows and secondary keys
+
+    OperationCounters& operator+=(const OperationCounters& other);
+};
+
+// table name and index number, -1 for the primary index
+typedef std::pair<uint64_t, int32_t> IndexId;
+
+struct ActionMetrics {
+    std::map<IndexId, OperationCounters> indexes;
+    uint64_t inline_actions = 0;
+    uint64_t inline_action_bytes = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+
+    [[nodiscard]] OperationCounters Total() const;
+    // counters of one table, all its indexes included
+    [[nodiscard]] OperationCounters OfTable(const std::string& table) const;
+    [[nodiscard]] std::string ToString() const;
+
+    ActionMetrics& operator+=(const ActionMetrics& other);
+};
+
+[[nodiscard]] std::string NameToString(uint64_t value);
+
+// secondary index tables have the index number in the low 4 bits of the table name
+[[nodiscard]] IndexId GetSecondaryIndexId(uint64_t table);
+
+// allocations made by the contract are counted while an action runs and no intrinsic is executed
+void SetAllocationCounting(bool enabled, ActionMetrics* metrics);
+
+class IntrinsicScope {
+public:
+    IntrinsicScope();
+    ~IntrinsicScope();
+};
+
+}
@@ -7,10 +7,135 @@
 #include <definitions/Definitions.hpp>
 #include <eosio/crypto.hpp>
 
+#include <cstring>
+
+#ifdef NOEOS
+namespace host {
+    class Dex;
+    class TableDecoder;
+}
+#endif
+
 CONTRACT Contract : public eosio::contract {
 public:
     using contract::contract;
 
+    // one swap of swap.batch, meaning of "in" and "out" is the same as for swap.path
+    struct SwapLeg {
+        eosio::symbol pair_token;
+        eosio::extended_asset in;
+        eosio::extended_asset out;
+        bool exact_in = false;
+    };
+
+    // single swap against a pair, "in + fee" is taken from the user
+    struct SwapHop {
+        eosio::extended_asset in;
+        eosio::extended_asset fee;
+        eosio::extended_asset fee_collector_share;
+        eosio::extended_asset out;
+    };
+
+    // result of quote.swap, "max_out" is the most the pair can pay out keeping its min liquidity
+    struct SwapQuote {
+        SwapHop hop;
+        eosio::extended_asset max_out;
+    };
+
+    struct AddLiquidityRequest {
+        eosio::symbol token;
+        eosio::extended_asset max_asset1;
+        eosio::extended_asset max_asset2;
+    };
+
+    // result of quote.add and quote.remove, assets are paid by or to the user
+    struct LiquidityQuote {
+        eosio::asset liquidity;
+        eosio::extended_asset asset1;
+        eosio::extended_asset asset2;
+        eosio::extended_asset fee1;
+        eosio::extended_asset fee2;
+        eosio::asset min_liquidity;
+    };
+
+    // accumulators of a pair at "time", the TWAP between two checkpoints is the difference of the accumulators
+    // divided by the seconds between them
+    struct PriceCheckpoint {
+        eosio::time_point_sec time;
+        uint128_t price1_cumulative = 0;
+        uint128_t price2_cumulative = 0;
+    };
+
+    // result of quote.twap, prices are Q64.64 ratios of the pools: price1 is pool2 per pool1, price2 the inverse
+    struct PriceTwap {
+        PriceCheckpoint start;
+        PriceCheckpoint end;
+        uint128_t price1 = 0;
+        uint128_t price2 = 0;
+    };
+
+    // activity of a pair, "1" amounts are in the pool1 token and "2" amounts in the pool2 token;
+    // fees include the collector share and the add liquidity fee, sums and counts saturate
+    struct VolumeStats {
+        uint64_t volume1_in = 0;
+        uint64_t volume1_out = 0;
+        uint64_t volume2_in = 0;
+        uint64_t volume2_out = 0;
+        uint64_t fee1 = 0;
+        uint64_t fee2 = 0;
+        uint32_t trades = 0;
+        uint32_t liquidity_changes = 0;
+    };
+
+    // result of quote.volume, "start" is the beginning of the first bucket
+    struct VolumeQuote {
+        eosio::time_point_sec start;
+        eosio::time_point_sec end;
+        VolumeStats stats;
+    };
+
+    // result of quote.route, "path" can be passed to swap.path with exact_in
+    struct RouteQuote {
+        std::vector<eosio::symbol> path;
+        eosio::extended_asset out;
+    };
+
+    // pools of a pair after an action
+    struct PairReserves {
+        eosio::extended_asset pool1;
+        eosio::extended_asset pool2;
+        int64_t raw_pool1_amount = 0;
+        int64_t raw_pool2_amount = 0;
+        eosio::asset supply;
+    };
+
+    // return value of swap and swap.in, "refund" is the rest of the deposit transferred back
+    struct SwapResult {
+        SwapHop hop;
+        eosio::extended_asset refund;
+        PairReserves reserves;
+    };
+
+    // return value of addliquidity, addliq.zap and remliquidity; assets are paid by or to the user,
+    // refunds are transferred back and are zero for remliquidity
+    struct LiquidityResult {
+        eosio::asset liquidity;
+        eosio::extended_asset asset1;
+        eosio::extended_asset asset2;
+        eosio::extended_asset fee1;
+        eosio::extended_asset fee2;
+        eosio::extended_asset refund1;
+        eosio::extended_asset refund2;
+        PairReserves reserves;
+    };
+
+    // one recipient of transfer.many
+    struct TransferEntry {
+        eosio::name to;
+        eosio::asset quantity;
+        std::string memo;
+    };
+
     // notifications
     [[eosio::on_notify("eosio.token::transfer")]]
     void OnEosTokenDeposit(eosio::name from, eosio::name to, eosio::asset quantity, const std::string& memo);
@@ -27,28 +152,128 @@ public:
     [[eosio::action("remove.pair")]]
     void RemovePair(eosio::symbol token, eosio::name liquidity_holder);
 
+    // adds already created pairs to the pair directory
+    [[eosio::action("index.pairs")]]
+    void IndexPairs(std::vector<eosio::symbol_code> pair_codes);
+
+    // rewrites the pair rows in the current layout, so that readers using the ABI decode every row;
+    // it is run over all pairs once after the upgrade
+    [[eosio::action("migrate.pairs")]]
+    void MigratePairs(std::vector<eosio::symbol_code> pair_codes);
+
+    // accepts deposits of the token even without a pair, for example before create.pair
+    [[eosio::action("token.allow")]]
+    void AllowToken(eosio::extended_symbol token, bool allowed);
+
+    // recounts the pairs of the tokens from the pair directory, for pairs created before the allowlist
+    [[eosio::action("index.tokens")]]
+    void IndexTokens(std::vector<eosio::extended_symbol> tokens);
+
+    // erases up to max_rows deposits of the user in tokens which are not accepted anymore,
+    // the balances are transferred back if "refund" is set and forfeited otherwise
+    [[eosio::action("clean.deps")]]
+    void CleanDeposits(eosio::name user, uint32_t max_rows, bool refund);
+
     [[eosio::action("set.fee")]]
     void SetFee(eosio::symbol token, int new_fee, eosio::name fee_account, int fee_contract_rate);
 
+    // with keep_on_deposit set by swap, swap.in, addliquidity, addliq.zap and remliquidity, the received tokens
+    // are added to the deposits of the user instead of being transferred, and unused funds stay on deposit
+    // (the returned refunds are zero); the option may be left out by callers which do not know it
     [[eosio::action("addliquidity")]]
-    void AddLiquidity(eosio::name user, eosio::symbol token, eosio::extended_asset max_asset1,
-                      eosio::extended_asset max_asset2);
+    LiquidityResult AddLiquidity(eosio::name user, eosio::symbol token, eosio::extended_asset max_asset1,
+                                 eosio::extended_asset max_asset2, eosio::binary_extension<bool> keep_on_deposit);
+
+    // adds liquidity with one token of the pair: the part of "in" which balances the rest is swapped against
+    // the pair itself and the pair row is updated once; unused funds are refunded as by addliquidity
+    [[eosio::action("addliq.zap")]]
+    LiquidityResult AddLiquiditySingle(eosio::name user, eosio::symbol token, eosio::extended_asset in,
+                                       eosio::asset min_liquidity, eosio::binary_extension<bool> keep_on_deposit);
 
     [[eosio::action("remliquidity")]]
-    void RemoveLiquidity(eosio::name user, eosio::asset to_sell, eosio::extended_asset min_asset1,
-                         eosio::extended_asset min_asset2);
+    LiquidityResult RemoveLiquidity(eosio::name user, eosio::asset to_sell, eosio::extended_asset min_asset1,
+                                    eosio::extended_asset min_asset2, eosio::binary_extension<bool> keep_on_deposit);
 
     [[eosio::action("swap")]]
-    void Swap(eosio::name user, eosio::symbol pair_token, eosio::extended_asset max_in,
-              eosio::extended_asset expected_out);
+    SwapResult Swap(eosio::name user, eosio::symbol pair_token, eosio::extended_asset max_in,
+                    eosio::extended_asset expected_out, eosio::binary_extension<bool> keep_on_deposit);
+
+    // sells exactly "in" (fee included) and fails if less than "min_out" is received
+    [[eosio::action("swap.in")]]
+    SwapResult SwapIn(eosio::name user, eosio::symbol pair_token, eosio::extended_asset in,
+                      eosio::extended_asset min_out, eosio::binary_extension<bool> keep_on_deposit);
+
+    // swaps through an ordered list of pairs; with exact_in "in" is the exact amount to sell
+    // and "out" is the minimal amount to receive, otherwise "in" limits the first hop
+    // and "out" is the exact amount to receive
+    [[eosio::action("swap.path")]]
+    void SwapPath(eosio::name user, std::vector<eosio::symbol> path, eosio::extended_asset in,
+                  eosio::extended_asset out, bool exact_in);
 
+    // executes swaps in order and settles the net amount of every touched token of the user once: spent tokens
+    // are taken from the deposits, received ones are sent with one transfer per token
+    [[eosio::action("swap.batch")]]
+    void SwapBatch(eosio::name user, std::vector<SwapLeg> legs);
+
+    // read-only quotes against the current state, every request is evaluated independently;
+    // limits of the requests ("in" of exact-out and "out" of exact-in swaps) are not checked
+    [[eosio::action("quote.swap"), eosio::read_only]]
+    std::vector<SwapQuote> QuoteSwap(std::vector<SwapLeg> requests);
+
+    [[eosio::action("quote.add"), eosio::read_only]]
+    std::vector<LiquidityQuote> QuoteAddLiquidity(std::vector<AddLiquidityRequest> requests);
+
+    [[eosio::action("quote.remove"), eosio::read_only]]
+    std::vector<LiquidityQuote> QuoteRemoveLiquidity(std::vector<eosio::asset> requests);
+
+    // time-weighted prices from the latest observation at least "window" seconds old until now,
+    // window 0 returns the current checkpoint and the spot prices
+    [[eosio::action("quote.twap"), eosio::read_only]]
+    PriceTwap QuoteTwap(eosio::symbol_code pair_code, uint32_t window);
+
+    // activity of the pair in the hourly buckets covering the last "window" seconds
+    [[eosio::action("quote.volume"), eosio::read_only]]
+    VolumeQuote QuoteVolume(eosio::symbol_code pair_code, uint32_t window);
+
+    // best routes selling exactly "in" for out_token with up to max_hops pairs, best first; the search
+    // keeps ROUTE_RESULTS routes per token and evaluates at most MAX_ROUTE_EVALUATIONS swaps
+    [[eosio::action("quote.route"), eosio::read_only]]
+    std::vector<RouteQuote> QuoteRoute(eosio::extended_asset in, eosio::extended_symbol out_token, uint8_t max_hops);
+
+    // the withdraw actions return the transferred amounts
     [[eosio::action("withdraw")]]
-    void Withdraw(eosio::name user, eosio::extended_symbol token);
+    eosio::extended_asset Withdraw(eosio::name user, eosio::extended_symbol token);
+
+    // withdraws up to max_rows deposits of the user (0 is no limit), legacy rows included,
+    // with one transfer per token
+    [[eosio::action("withdraw.all")]]
+    std::vector<eosio::extended_asset> WithdrawAll(eosio::name user, uint32_t max_rows);
+
+    // withdraws the deposits of the listed tokens, tokens without a deposit are skipped
+    [[eosio::action("withdraw.sym")]]
+    std::vector<eosio::extended_asset> WithdrawTokens(eosio::name user, std::vector<eosio::extended_symbol> tokens);
+
+    // pays out all fees accrued to the collector
+    [[eosio::action("claim.fees")]]
+    void ClaimFees(eosio::name collector);
+
+    // moves up to max_rows deposits of the user from the legacy "deposits" table
+    [[eosio::action("migrate.dep")]]
+    void MigrateDeposits(eosio::name user, uint32_t max_rows);
 
     [[eosio::action("transfer")]]
     void Transfer(eosio::name from, eosio::name to, eosio::asset quantity, const std::string& memo);
 
+    // transfers of one LP token to many recipients, the sender is debited once for the total;
+    // the sender and every recipient are notified, a recipient may appear only once
+    [[eosio::action("transfer.many")]]
+    void TransferMany(eosio::name from, const std::vector<TransferEntry>& transfers);
+
 private:
+#ifdef NOEOS
+    friend class host::Dex;
+    friend class host::TableDecoder;
+#endif
 
     void SubBalance(eosio::name user, eosio::asset value);
     void AddBalance(eosio::name user, eosio::asset value);
@@ -56,11 +281,21 @@ private:
     void AddExtBalance(eosio::name user, eosio::extended_asset value);
     void SubExtBalance(eosio::name user, eosio::extended_asset value);
     eosio::extended_asset Refund(eosio::name user, eosio::extended_symbol token);
+    void SendWithdrawals(eosio::name user, const std::vector<eosio::extended_asset>& to_transfer);
+    // transfers "value" to the user or adds it to the user's deposits, nothing if it is not positive
+    void PayOut(eosio::name user, eosio::extended_asset value, const std::string& memo, bool keep_on_deposit);
+
+    void AccrueFee(eosio::name collector, eosio::extended_asset fee);
+
+    // swaps an incoming transfer without writing a deposit, memo is "swap:<pair>:<min_out>[:<recipient>]"
+    void SwapFromMemo(eosio::name from, eosio::extended_asset in, const std::string& memo);
 
     // token scope
+    // rows written before v2 have "max_supply" after "supply", they are read by operator>>
+    // and rewritten in v2 layout by migrate.pairs or on the next modify; the v1 branch of operator>> can be
+    // dropped when no such row is left. Later fields are only appended, rows without them read them as zero
     TABLE CurrencyStatRecord {
         eosio::asset supply;
-        eosio::asset max_supply;
         eosio::name issuer;
 
         eosio::extended_asset pool1;
@@ -74,12 +309,42 @@ private:
         int64$ raw_pool2_amount = 0;
         int64$ min_liquidity_amount = 0;
 
+        // sums of the Q64.64 prices multiplied by seconds, they wrap around and only differences are meaningful;
+        // rows written before have none and start accumulating on the next update
+        uint128_t price1_cumulative = 0;
+        uint128_t price2_cumulative = 0;
+        uint32$ last_update = 0;
+
         [[nodiscard]] uint64_t primary_key() const {
             return supply.symbol.code().raw();
         }
     };
     typedef eosio::multi_index< "stat"_n, CurrencyStatRecord > CurrencyStatsTable;
 
+    // pair token scope
+    // ring of accumulator snapshots, the first update of a pair in each period is kept
+    // in the slot (time / TWAP_OBSERVATION_PERIOD) % TWAP_OBSERVATIONS
+    TABLE ObservationRecord {
+        uint64_t slot = 0;
+        uint32$ time = 0;
+        uint128_t price1_cumulative = 0;
+        uint128_t price2_cumulative = 0;
+
+        [[nodiscard]] uint64_t primary_key() const { return slot; }
+    };
+    typedef eosio::multi_index< "observations"_n, ObservationRecord > ObservationsTable;
+
+    // pair token scope
+    // ring of hourly activity, the bucket of "time" is in the slot (time / VOLUME_BUCKET_PERIOD) % VOLUME_BUCKETS
+    TABLE VolumeRecord {
+        uint64_t slot = 0;
+        uint32$ period = 0; // time / VOLUME_BUCKET_PERIOD, a bucket of an older period is reset on the next write
+        VolumeStats stats;
+
+        [[nodiscard]] uint64_t primary_key() const { return slot; }
+    };
+    typedef eosio::multi_index< "volumes"_n, VolumeRecord > VolumesTable;
+
     // token-pairs balances
     // user scope
     TABLE BalanceRecord {
@@ -92,7 +357,19 @@ private:
     typedef eosio::multi_index< "accounts"_n, BalanceRecord > BalancesTable;
 
     // user scope
+    // key is a hash of the extended symbol, on collision the next free key is used
     TABLE DepositRecord {
+        uint64_t key = 0;
+        eosio::extended_asset balance;
+
+        [[nodiscard]] uint64_t primary_key() const { return key; }
+        [[nodiscard]] eosio::extended_symbol get_token() const { return balance.get_extended_symbol(); }
+    };
+    typedef eosio::multi_index< "depositsv2"_n, DepositRecord > DepositsTable;
+
+    // user scope
+    // replaced by DepositsTable, rows are moved on the first access or by migrate.dep
+    TABLE LegacyDepositRecord {
         uint64_t id = 0;
         eosio::extended_asset balance;
 
@@ -101,20 +378,198 @@ private:
             return GetIndexFromToken(balance.get_extended_symbol());
         }
     };
-    typedef eosio::multi_index< "deposits"_n, DepositRecord,
-            eosio::indexed_by<"extended"_n, eosio::const_mem_fun<DepositRecord, uint128_t,
-            &DepositRecord::secondary_key>>
-            > DepositsTable;
+    typedef eosio::multi_index< "deposits"_n, LegacyDepositRecord,
+            eosio::indexed_by<"extended"_n, eosio::const_mem_fun<LegacyDepositRecord, uint128_t,
+            &LegacyDepositRecord::secondary_key>>
+            > LegacyDepositsTable;
+
+    // contract scope
+    // directory of all pairs, searchable by both tokens or by one of them
+    TABLE PairRecord {
+        eosio::symbol token;
+        eosio::extended_symbol token1;
+        eosio::extended_symbol token2;
+
+        [[nodiscard]] uint64_t primary_key() const {
+            return token.code().raw();
+        }
+        [[nodiscard]] eosio::checksum256 tokens_key() const {
+            return GetIndexFromTokens(token1, token2);
+        }
+        [[nodiscard]] uint128_t token1_key() const {
+            return GetIndexFromToken(token1);
+        }
+        [[nodiscard]] uint128_t token2_key() const {
+            return GetIndexFromToken(token2);
+        }
+    };
+    typedef eosio::multi_index< "pairs"_n, PairRecord,
+            eosio::indexed_by<"tokens"_n, eosio::const_mem_fun<PairRecord, eosio::checksum256,
+            &PairRecord::tokens_key>>,
+            eosio::indexed_by<"token1"_n, eosio::const_mem_fun<PairRecord, uint128_t,
+            &PairRecord::token1_key>>,
+            eosio::indexed_by<"token2"_n, eosio::const_mem_fun<PairRecord, uint128_t,
+            &PairRecord::token2_key>>
+            > PairsTable;
+
+    // collector scope
+    // key is a hash of the extended symbol as in DepositsTable
+    TABLE FeeRecord {
+        uint64_t key = 0;
+        eosio::extended_asset balance;
+
+        [[nodiscard]] uint64_t primary_key() const { return key; }
+        [[nodiscard]] eosio::extended_symbol get_token() const { return balance.get_extended_symbol(); }
+    };
+    typedef eosio::multi_index< "fees"_n, FeeRecord > FeesTable;
+
+    // contract scope
+    // tokens accepted by the transfer notification: tokens of pairs and tokens allowed by the contract;
+    // key is a hash of the extended symbol as in DepositsTable
+    TABLE TokenRecord {
+        uint64_t key = 0;
+        eosio::extended_symbol token;
+        uint32$ pairs = 0;
+        bool allowed = false;
+
+        [[nodiscard]] uint64_t primary_key() const { return key; }
+        [[nodiscard]] eosio::extended_symbol get_token() const { return token; }
+    };
+    typedef eosio::multi_index< "tokens"_n, TokenRecord > TokensTable;
 
     [[nodiscard]] static uint128_t GetIndexFromToken(eosio::extended_symbol token);
+    [[nodiscard]] static uint64_t GetKeyFromToken(eosio::extended_symbol token);
+    // the same for (token1, token2) and (token2, token1)
+    [[nodiscard]] static eosio::checksum256 GetIndexFromTokens(eosio::extended_symbol token1,
+                                                               eosio::extended_symbol token2);
+
+    void AddPairToDirectory(eosio::symbol token, eosio::extended_symbol token1, eosio::extended_symbol token2);
+    void RemovePairFromDirectory(eosio::symbol token);
+
+    [[nodiscard]] bool IsTokenAccepted(eosio::extended_symbol token) const;
+    // changes the number of pairs of the token, the row is erased when nothing keeps the token accepted
+    void ChangeTokenPairs(eosio::extended_symbol token, int32_t change);
+
+    // rows keyed by GetKeyFromToken of their token, on collision the next free key is used
+    template<typename Table>
+    [[nodiscard]] static typename Table::const_iterator FindByToken(const Table& table, eosio::extended_symbol token);
+    template<typename Table, typename Setter>
+    typename Table::const_iterator EmplaceByToken(Table& table, eosio::extended_symbol token, Setter&& setter);
+
+    DepositsTable::const_iterator FindOrMigrateDeposit(DepositsTable& deposits, eosio::extended_symbol token);
+    DepositsTable::const_iterator EmplaceDeposit(DepositsTable& deposits, eosio::extended_asset balance);
+
+    // liquidity minted or burned with raw amounts paid ("to_pay") and the change of the pools ("to_pool")
+    struct LiquidityChange {
+        int64_t liquidity = 0;
+        eosio::extended_asset to_pay1;
+        eosio::extended_asset to_pay2;
+        eosio::extended_asset to_pool1;
+        eosio::extended_asset to_pool2;
+        eosio::extended_asset fee1;
+        eosio::extended_asset fee2;
+    };
+
+    [[nodiscard]] static eosio::extended_symbol GetOppositeToken(const CurrencyStatRecord& pair,
+                                                                 eosio::extended_symbol token);
+    [[nodiscard]] static SwapHop CalculateSwapByOut(const CurrencyStatRecord& pair, eosio::extended_symbol in_token,
+                                                    eosio::extended_asset expected_out);
+    [[nodiscard]] static SwapHop CalculateSwapByIn(const CurrencyStatRecord& pair, eosio::extended_asset total_in,
+                                                   eosio::extended_symbol out_token);
+    static void ApplySwap(CurrencyStatRecord& record, const SwapHop& hop);
+    // "out" of CalculateSwapByIn followed by ApplySwap, 0 where one of them fails
+    [[nodiscard]] static int64_t EstimateSwapOut(const CurrencyStatRecord& pair, eosio::extended_asset total_in);
+
+    [[nodiscard]] static LiquidityChange CalculateAddLiquidity(const CurrencyStatRecord& pair,
+                                                               eosio::extended_asset max_asset1,
+                                                               eosio::extended_asset max_asset2);
+    static void ApplyAddLiquidity(CurrencyStatRecord& record, const LiquidityChange& change);
+    // the part of "in" to swap before adding liquidity with the rest and the swapped out
+    [[nodiscard]] static int64_t CalculateZapAmount(const CurrencyStatRecord& pair, eosio::extended_asset in);
+    [[nodiscard]] static LiquidityChange CalculateRemoveLiquidity(const CurrencyStatRecord& pair, eosio::asset to_sell);
+    static void ApplyRemoveLiquidity(CurrencyStatRecord& record, const LiquidityChange& change);
+    [[nodiscard]] static PairReserves GetReserves(const CurrencyStatRecord& pair);
+
+    // adds the prices of the pools before a change to the accumulators, at most once per second;
+    // true if it is the first update of the pair in the observation period
+    static bool AccumulatePrice(CurrencyStatRecord& record, uint32_t now);
+    void RecordObservation(const CurrencyStatRecord& record);
+    void RemoveObservations(eosio::symbol_code pair_code);
+
+    // adds the activity to the bucket of the current hour
+    void RecordVolume(eosio::symbol_code pair_code, const VolumeStats& change);
+    void RecordSwapVolume(const CurrencyStatRecord& pair, const SwapHop& hop);
+    void RecordLiquidityVolume(const CurrencyStatRecord& pair, const LiquidityChange& change);
+    void RemoveVolumes(eosio::symbol_code pair_code);
+    static void AddVolume(VolumeStats& total, const VolumeStats& value);
+
+    // takes "in + fee" from the deposit, applies the hop to the pair and pays out the refund of the rest of the
+    // deposit and "out", both stay on deposit with keep_on_deposit; shared by swap and swap.in
+    SwapResult SettleSwap(eosio::name user, CurrencyStatsTable& stats_table,
+                          CurrencyStatsTable::const_iterator token_it, const SwapHop& hop, bool keep_on_deposit);
+
+    // stats_table.modify which keeps the price accumulators and observations
+    template<typename Modifier>
+    void ModifyPair(CurrencyStatsTable& stats_table, CurrencyStatsTable::const_iterator token_it, Modifier&& modifier);
 
     template<typename DataStream>
     friend DataStream& operator>>(DataStream& ds, CurrencyStatRecord& v);
 };
 
+template<typename Table>
+typename Table::const_iterator Contract::FindByToken(const Table& table, const eosio::extended_symbol token) {
+    const uint64_t key = GetKeyFromToken(token);
+
+    for (auto row_it = table.lower_bound(key); row_it != table.end() && row_it->key - key < MAX_KEY_PROBES;
+         ++row_it) {
+        if (row_it->get_token() == token) {
+            return row_it;
+        }
+    }
+
+    return table.end();
+}
+
+template<typename Table, typename Setter>
+typename Table::const_iterator Contract::EmplaceByToken(Table& table, const eosio::extended_symbol token,
+                                                        Setter&& setter) {
+    const uint64_t key = GetKeyFromToken(token);
+
+    // the first key which is not taken by another token
+    uint64_t free_key = key;
+    for (auto row_it = table.lower_bound(key); row_it != table.end() && row_it->key == free_key; ++row_it) {
+        free_key++;
+    }
+    eosio::check(free_key - key < MAX_KEY_PROBES, "too many key collisions");
+
+    return table.emplace(get_self(), [&](auto& record) {
+        record.key = free_key;
+        setter(record);
+    });
+}
+
 template<typename DataStream>
 DataStream& operator>>(DataStream& ds, Contract::CurrencyStatRecord& v) {
+    ds >> v.supply;
+
+    // v1 row, skip "max_supply" which is always MAX_SUPPLY of the supply symbol
+    if (ds.remaining() >= sizeof(int64_t) + sizeof(uint64_t)) {
+        int64_t max_supply_amount = 0;
+        uint64_t max_supply_symbol = 0;
+        memcpy(&max_supply_amount, ds.pos(), sizeof(int64_t));
+        memcpy(&max_supply_symbol, ds.pos() + sizeof(int64_t), sizeof(uint64_t));
+
+        if (max_supply_amount == MAX_SUPPLY && max_supply_symbol == v.supply.symbol.raw()) {
+            ds.skip(sizeof(int64_t) + sizeof(uint64_t));
+        }
+    }
+
+    bool is_supply = true;
     boost::pfr::for_each_field(v, [&](auto& field) {
+        if (is_supply) {
+            is_supply = false;
+            return;
+        }
         if (ds.remaining() <= 0) {
             return;
         }
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+// Integer kernel of the pool math. Only 64-bit divisions and 128-bit multiplications, additions and shifts
+// are used: a 128-bit division is a slow __udivti3/__divti3 libcall in WASM. Operands that fit in 64 bits
+// take a single 64-bit division.
+
+typedef unsigned __int128 uint128_t;
+
+constexpr uint64_t UINT64_MAX_VALUE = ~uint64_t(0);
+
+// (high:low) / divisor for high < divisor, so the quotient fits in 64 bits (Hacker's Delight, divlu)
+constexpr uint64_t DivideWide(const uint64_t high, const uint64_t low, uint64_t divisor, uint64_t& remainder) {
+    const uint64_t base = uint64_t(1) << 32;
+    const int shift = __builtin_clzll(divisor);
+
+    divisor <<= shift;
+    const uint64_t divisor1 = divisor >> 32;
+    const uint64_t divisor0 = divisor & 0xFFFFFFFF;
+
+    const uint64_t numerator32 = shift == 0 ? high : (high << shift) | (low >> (64 - shift));
+    const uint64_t numerator10 = low << shift;
+    const uint64_t numerator1 = numerator10 >> 32;
+    const uint64_t numerator0 = numerator10 & 0xFFFFFFFF;
+
+    uint64_t quotient1 = numerator32 / divisor1;
+    uint64_t rest = numerator32 - quotient1 * divisor1;
+    while (quotient1 >= base || quotient1 * divisor0 > base * rest + numerator1) {
+        quotient1--;
+        rest += divisor1;
+        if (rest >= base) {
+            break;
+        }
+    }
+
+    const uint64_t numerator21 = numerator32 * base + numerator1 - quotient1 * divisor;
+    uint64_t quotient0 = numerator21 / divisor1;
+    rest = numerator21 - quotient0 * divisor1;
+    while (quotient0 >= base || quotient0 * divisor0 > base * rest + numerator0) {
+        quotient0--;
+        rest += divisor1;
+        if (rest >= base) {
+            break;
+        }
+    }
+
+    remainder = (numerator21 * base + numerator0 - quotient0 * divisor) >> shift;
+    return quotient1 * base + quotient0;
+}
+
+// floor(sqrt(value)): digit by digit in constant expressions, otherwise the f64 estimate corrected to the exact root
+constexpr uint64_t ISqrt(const uint128_t value) {
+    if (!std::is_constant_evaluated()) {
+        const double estimate = __builtin_sqrt(static_cast<double>(value));
+        uint64_t root = estimate >= 18446744073709551615.0 ? UINT64_MAX_VALUE : static_cast<uint64_t>(estimate);
+
+        // the estimate is off by up to 2^11 above 2^106, one Newton step leaves at most 1
+        const uint64_t high = uint64_t(value >> 64);
+        if (root >> 53 != 0 && high < root) {
+            uint64_t remainder = 0;
+            const uint64_t quotient = DivideWide(high, uint64_t(value), root, remainder);
+            root = uint64_t((uint128_t(root) + quotient) / 2);
+        }
+
+        while (uint128_t(root) * root > value) {
+            root--;
+        }
+        while (root != UINT64_MAX_VALUE && uint128_t(root + 1) * (root + 1) <= value) {
+            root++;
+        }
+        return root;
+    }
+
+    uint128_t rest = value;
+    uint128_t result = 0;
+    uint128_t bit = uint128_t(1) << 126;
+    while (bit > rest) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (rest >= result + bit) {
+            rest -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return uint64_t(result);
+}
+
+// a * b / divisor rounded down, UINT64_MAX_VALUE if the quotient does not fit in 64 bits
+constexpr uint64_t MulDivDown(const uint64_t a, const uint64_t b, const uint64_t divisor, uint64_t& remainder) {
+    const uint128_t product = uint128_t(a) * b;
+    const uint64_t high = uint64_t(product >> 64);
+    const uint64_t low = uint64_t(product);
+
+    if (high == 0) {
+        remainder = low % divisor;
+        return low / divisor;
+    }
+    if (high >= divisor) {
+        remainder = 0;
+        return UINT64_MAX_VALUE;
+    }
+    return DivideWide(high, low, divisor, remainder);
+}
+
+constexpr uint64_t MulDivDown(const uint64_t a, const uint64_t b, const uint64_t divisor) {
+    uint64_t remainder = 0;
+    return MulDivDown(a, b, divisor, remainder);
+}
+
+// a * b / divisor rounded up, UINT64_MAX_VALUE if the quotient does not fit in 64 bits
+constexpr uint64_t MulDivUp(const uint64_t a, const uint64_t b, const uint64_t divisor) {
+    uint64_t remainder = 0;
+    const uint64_t result = MulDivDown(a, b, divisor, remainder);
+    return remainder != 0 && result != UINT64_MAX_VALUE ? result + 1 : result;
+}
+
+// numerator / denominator as an unsigned Q64.64 fixed point number
+constexpr uint128_t DivideToQ64(const uint64_t numerator, const uint64_t denominator) {
+    uint64_t remainder = 0;
+    const uint64_t fraction = DivideWide(numerator % denominator, 0, denominator, remainder);
+    return (uint128_t(numerator / denominator) << 64) | fraction;
+}
+
+// value / divisor rounded down, for a 128-bit value
+constexpr uint128_t DivideBy64(const uint128_t value, const uint64_t divisor) {
+    const uint64_t high = uint64_t(value >> 64);
+    uint64_t remainder = 0;
+    const uint64_t low = DivideWide(high % divisor, uint64_t(value), divisor, remainder);
+    return (uint128_t(high / divisor) << 64) | low;
+}
+
+static_assert(ISqrt(0) == 0 && ISqrt(15) == 3 && ISqrt(16) == 4);
+static_assert(ISqrt(uint128_t(999999999999999) * 999999999999999) == 999999999999999);
+static_assert(ISqrt(uint128_t(999999999999999) * 999999999999999 - 1) == 999999999999998);
+static_assert(MulDivDown(UINT64_MAX_VALUE, UINT64_MAX_VALUE, UINT64_MAX_VALUE) == UINT64_MAX_VALUE);
+static_assert(MulDivDown(uint64_t(1) << 63, 4, 2) == UINT64_MAX_VALUE);
+static_assert(MulDivDown(uint64_t(1) << 62, 5, 3) == 7686143364045646506ULL);
+static_assert(MulDivUp(7, 3, 2) == 11 && MulDivDown(7, 3, 2) == 10);
+static_assert(DivideToQ64(3, 2) == (uint128_t(3) << 63) && DivideToQ64(1, 3) == 0x5555555555555555);
+static_assert(DivideBy64(~uint128_t(0), 1) == ~uint128_t(0) && DivideBy64(uint128_t(6) << 64, 3) == uint128_t(2) << 64);
@@ -1,16 +1,43 @@
 #pragma once
 
 #include <cstdint>
+#include <string_view>
+#include <vector>
 #include <eosio/asset.hpp>
 #include <definitions/Definitions.hpp>
+#include <Math.hpp>
 
-int64_t GetRateOf(int64_t value, int64_t rate) {
+// the message is built only when the check fails; DEX_EAGER_CHECKS builds it on every call as plain check did,
+// for the before/after benchmark of the host build
+template<typename MessageBuilder>
+inline void LazyCheck(const bool condition, MessageBuilder&& build_message) {
+#ifdef DEX_EAGER_CHECKS
+    eosio::check(condition, build_message());
+#else
+    if (!condition) {
+        eosio::check(false, build_message());
+    }
+#endif
+}
+
+// negative arguments keep the signed 128-bit path
+inline int64_t GetRateOf(int64_t value, int64_t rate) {
+    if (value >= 0 && rate >= 0) {
+        return static_cast<int64_t>(MulDivDown(value, rate, MAX_FEE));
+    }
     return static_cast<int64_t>(
         (static_cast<int128_t>(value) * static_cast<int128_t>(rate)) / DEFAULT_FEE_PRECISION
     ) / 100;
 }
 
-int64_t GetLiquidity(const int64_t in_amount, const int64_t supply, const int64_t pool) {
+inline int64_t GetLiquidity(const int64_t in_amount, const int64_t supply, const int64_t pool) {
+    if (in_amount >= 0 && supply >= 0 && pool > 0) {
+        const uint64_t result = MulDivDown(in_amount, supply, pool);
+        eosio::check(result <= static_cast<uint64_t>(eosio::asset::max_amount), "Transaction amount is too large");
+
+        return static_cast<int64_t>(result);
+    }
+
     const uint128_t result = (static_cast<uint128_t>(in_amount) * static_cast<uint128_t>(supply))
         / static_cast<uint128_t>(pool);
     eosio::check(result <= static_cast<uint128_t>(eosio::asset::max_amount), "Transaction amount is too large");
@@ -18,10 +45,51 @@ int64_t GetLiquidity(const int64_t in_amount, const int64_t supply, const int64_
     return static_cast<int64_t>(result);
 }
 
-int64_t CalculateToPayAmount(const int64_t liquidity, const int64_t pool, const int64_t supply) {
+inline int64_t CalculateToPayAmount(const int64_t liquidity, const int64_t pool, const int64_t supply) {
     return GetLiquidity(liquidity, pool, supply);
 }
 
-int64_t CalculateInAmount(const int64_t out_amount, const int64_t pool_in_amount, const int64_t pool_out_amount) {
+inline int64_t CalculateInAmount(const int64_t out_amount, const int64_t pool_in_amount,
+                                 const int64_t pool_out_amount) {
     return GetLiquidity(out_amount, pool_in_amount, pool_out_amount);
 }
+
+inline int64_t CalculateOutAmount(const int64_t in_amount, const int64_t pool_in_amount,
+                                  const int64_t pool_out_amount) {
+    return GetLiquidity(in_amount, pool_out_amount, pool_in_amount);
+}
+
+// total_amount * MAX_FEE / (MAX_FEE + rate) rounded down; "value + GetRateOf(value, rate)" never exceeds total_amount,
+// but as GetRateOf also rounds down the result can be a unit below the largest such value (150 at 1% gives 148)
+inline int64_t CalculateAmountWithoutFee(const int64_t total_amount, const int64_t rate) {
+    if (total_amount >= 0 && rate >= 0) {
+        return static_cast<int64_t>(MulDivDown(total_amount, MAX_FEE, MAX_FEE + rate));
+    }
+    return static_cast<int64_t>(
+        (static_cast<int128_t>(total_amount) * MAX_FEE) / (static_cast<int128_t>(MAX_FEE) + rate)
+    );
+}
+
+inline std::vector<std::string_view> SplitMemo(const std::string_view memo, const char delimiter) {
+    std::vector<std::string_view> result;
+    size_t begin = 0;
+    for (size_t end = memo.find(delimiter); end != std::string_view::npos; end = memo.find(delimiter, begin)) {
+        result.push_back(memo.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    result.push_back(memo.substr(begin));
+
+    return result;
+}
+
+inline int64_t ParseAmount(const std::string_view value) {
+    eosio::check(!value.empty() && value.size() <= 18, "invalid amount");
+
+    int64_t result = 0;
+    for (const char c : value) {
+        eosio::check(c >= '0' && c <= '9', "invalid amount");
+        result = result * 10 + (c - '0');
+    }
+
+    return result;
+}
@@ -1,5 +1,9 @@
 #pragma once
+#ifdef __clang__
 #pragma clang diagnostic ignored "-Wunknown-attributes"
+#else
+#pragma GCC diagnostic ignored "-Wattributes"
+#endif
 
 typedef __int128 int128_t;
 typedef unsigned __int128 uint128_t;
@@ -29,3 +33,19 @@ const int128_t DEFAULT_FEE_PRECISION = 1000000; // (denominator), 10^6
 const int64_t MAX_FEE = 100 * DEFAULT_FEE_PRECISION;
 const int64_t MIN_FEE = 100;
 const int128_t ADD_LIQUIDITY_FEE = 100;
+
+const uint32_t MAX_PATH_LENGTH = 5;
+const uint32_t MAX_BATCH_SIZE = 32;
+const uint64_t MAX_KEY_PROBES = 16;  // of the tables keyed by GetKeyFromToken
+
+// bounds of the quote.route search
+const uint32_t ROUTE_RESULTS = 3;
+const uint32_t MAX_ROUTE_EVALUATIONS = 512;
+
+// price observations of a pair, the ring covers TWAP_OBSERVATIONS periods of TWAP_OBSERVATION_PERIOD seconds
+const uint32_t TWAP_OBSERVATIONS = 48;
+const uint32_t TWAP_OBSERVATION_PERIOD = 300;
+
+// hourly activity of a pair for a week and the current hour
+const uint32_t VOLUME_BUCKETS = 7 * 24 + 1;
+const uint32_t VOLUME_BUCKET_PERIOD = 3600;
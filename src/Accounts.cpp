@@ -1,4 +1,5 @@
 #include <Contract.hpp>
+#include <algorithm>
 
 using namespace std;
 using namespace eosio;
@@ -50,3 +51,37 @@ void Contract::Transfer(name from, name to, asset quantity, const string& memo)
     SubBalance(from, quantity);
     AddBalance(to, quantity);
 }
+
+void Contract::TransferMany(name from, const vector<TransferEntry>& transfers) {
+    check(!transfers.empty(), "no transfers");
+
+    require_auth(from);
+    require_recipient(from);
+
+    // duplicates are found on the sorted recipients
+    vector<uint64_t> recipients;
+    recipients.reserve(transfers.size());
+
+    asset total { 0, transfers.front().quantity.symbol };
+    for (const TransferEntry& entry : transfers) {
+        check(entry.to != from, "cannot transfer to self");
+        check(entry.quantity.is_valid(), "invalid quantity");
+        check(entry.quantity.amount > 0, "must transfer positive quantity");
+        check(entry.quantity.symbol == total.symbol, "all transfers must be of one token");
+        check(entry.memo.size() <= 256, "memo has more than 256 bytes");
+        check(is_account(entry.to), "to account does not exist");
+
+        total += entry.quantity;
+        recipients.push_back(entry.to.value);
+    }
+
+    sort(recipients.begin(), recipients.end());
+    check(adjacent_find(recipients.begin(), recipients.end()) == recipients.end(), "duplicate recipient");
+
+    SubBalance(from, total);
+
+    for (const TransferEntry& entry : transfers) {
+        require_recipient(entry.to);
+        AddBalance(entry.to, entry.quantity);
+    }
+}
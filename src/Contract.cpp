@@ -1,11 +1,27 @@
 #include <Contract.hpp>
 #include <eosio.token.hpp>
-#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <map>
 #include <Util.hpp>
 
 using namespace std;
 using namespace eosio;
 
+template<typename Modifier>
+void Contract::ModifyPair(CurrencyStatsTable& stats_table, const CurrencyStatsTable::const_iterator token_it,
+                          Modifier&& modifier) {
+    bool observe = false;
+    stats_table.modify(token_it, get_self(), [&](CurrencyStatRecord& record) {
+        observe = AccumulatePrice(record, current_time_point().sec_since_epoch());
+        modifier(record);
+    });
+
+    if (observe) {
+        RecordObservation(*token_it);
+    }
+}
+
 void Contract::CreatePair(name issuer, symbol_code new_symbol_code, extended_asset initial_pool1,
                           extended_asset initial_pool2, int initial_fee, name fee_contract, int fee_contract_rate) {
     require_auth(get_self());
@@ -22,7 +38,7 @@ void Contract::CreatePair(name issuer, symbol_code new_symbol_code, extended_ass
     const uint8_t precision = (initial_pool1.quantity.symbol.precision()
         + initial_pool2.quantity.symbol.precision()) / 2;
 
-    const int128_t amount = sqrt(int128_t(initial_pool1.quantity.amount) * int128_t(initial_pool2.quantity.amount));
+    const uint64_t amount = ISqrt(uint128_t(initial_pool1.quantity.amount) * uint128_t(initial_pool2.quantity.amount));
     const symbol new_symbol { new_symbol_code, precision };
     const asset new_token { int64_t(amount), new_symbol };
 
@@ -34,9 +50,8 @@ void Contract::CreatePair(name issuer, symbol_code new_symbol_code, extended_ass
     SubExtBalance(issuer, initial_pool1);
     SubExtBalance(issuer, initial_pool2);
 
-    stats_table.emplace(get_self(), [&](CurrencyStatRecord& record) {
+    const auto new_token_it = stats_table.emplace(get_self(), [&](CurrencyStatRecord& record) {
         record.supply = new_token;
-        record.max_supply = asset { MAX_SUPPLY, new_symbol };
         record.issuer = issuer;
 
         record.pool1 = initial_pool1;
@@ -50,7 +65,12 @@ void Contract::CreatePair(name issuer, symbol_code new_symbol_code, extended_ass
         record.fee = initial_fee;
         record.fee_contract = fee_contract;
         record.fee_contract_rate = fee_contract_rate;
+
+        record.last_update = current_time_point().sec_since_epoch();
     });
+
+    RecordObservation(*new_token_it);
+    AddPairToDirectory(new_symbol, initial_pool1.get_extended_symbol(), initial_pool2.get_extended_symbol());
 }
 
 void Contract::RemovePair(const symbol token, const name liquidity_holder) {
@@ -69,6 +89,9 @@ void Contract::RemovePair(const symbol token, const name liquidity_holder) {
 
     // remove pair
     stats_table.erase(token_it);
+    RemovePairFromDirectory(token);
+    RemoveObservations(token.code());
+    RemoveVolumes(token.code());
 
     // transfer pools to issuer
     token::transfer_action transfer_pool1_action(to_transfer1.contract, { get_self(), "active"_n });
@@ -101,237 +124,677 @@ void Contract::SetFee(symbol token, int new_fee, name fee_account, int fee_contr
     });
 }
 
-void Contract::AddLiquidity(const name user, symbol token, const extended_asset max_asset1,
-                            const extended_asset max_asset2) {
+Contract::LiquidityResult Contract::AddLiquidity(const name user, symbol token, const extended_asset max_asset1,
+                                                 const extended_asset max_asset2,
+                                                 const binary_extension<bool> keep_on_deposit) {
     require_auth(user);
 
-    check(max_asset1.get_extended_symbol() != max_asset2.get_extended_symbol(), "assets cannot be the same");
-    check(max_asset1.quantity.amount > 0 && max_asset2.quantity.amount > 0, "assets must be positive");
-
     CurrencyStatsTable stats_table(get_self(), token.code().raw());
     const auto token_it = stats_table.find(token.code().raw());
     check (token_it != stats_table.end(), "pair token_it does not exist");
 
-    const asset supply = token_it->supply;
-    const extended_asset pool1 = token_it->pool1;
-    const extended_asset pool2 = token_it->pool2;
-    const int64_t raw_pool1_amount = token_it->raw_pool1_amount;
-    const int64_t raw_pool2_amount = token_it->raw_pool2_amount;
+    const LiquidityChange change = CalculateAddLiquidity(*token_it, max_asset1, max_asset2);
+
+    // fee calculation
+    const name fee_collector = token_it->fee_contract;
+
+    // sub user ext balances
+    SubExtBalance(user, change.to_pay1 + change.fee1);
+    SubExtBalance(user, change.to_pay2 + change.fee2);
+
+    // add balance to user
+    AddBalance(user, { change.liquidity, token });
+
+    // edit pair token params
+    ModifyPair(stats_table, token_it, [&](CurrencyStatRecord& record) {
+        ApplyAddLiquidity(record, change);
+    });
+    RecordLiquidityVolume(*token_it, change);
+
+    // transfer change back to user, it stays on deposit with keep_on_deposit
+    const bool keep = keep_on_deposit.value_or(false);
+    const extended_asset refund1 = keep
+        ? extended_asset { 0, change.to_pay1.get_extended_symbol() }
+        : Refund(user, change.to_pay1.get_extended_symbol());
+    const extended_asset refund2 = keep
+        ? extended_asset { 0, change.to_pay2.get_extended_symbol() }
+        : Refund(user, change.to_pay2.get_extended_symbol());
+    PayOut(user, refund1, "refund of unused funds", false);
+    PayOut(user, refund2, "refund of unused funds", false);
+
+    // accrue fee to collector
+    AccrueFee(fee_collector, change.fee1);
+    AccrueFee(fee_collector, change.fee2);
+
+    return {
+        { change.liquidity, token },
+        change.to_pay1 + change.fee1,
+        change.to_pay2 + change.fee2,
+        change.fee1,
+        change.fee2,
+        refund1,
+        refund2,
+        GetReserves(*token_it)
+    };
+}
+
+Contract::LiquidityChange Contract::CalculateAddLiquidity(const CurrencyStatRecord& pair,
+                                                          const extended_asset max_asset1,
+                                                          const extended_asset max_asset2) {
+    check(max_asset1.get_extended_symbol() != max_asset2.get_extended_symbol(), "assets cannot be the same");
+    check(max_asset1.quantity.amount > 0 && max_asset2.quantity.amount > 0, "assets must be positive");
+
+    const asset supply = pair.supply;
+    const extended_asset pool1 = pair.pool1;
+    const extended_asset pool2 = pair.pool2;
+    const int64_t raw_pool1_amount = pair.raw_pool1_amount;
+    const int64_t raw_pool2_amount = pair.raw_pool2_amount;
 
     check(max_asset1.get_extended_symbol() == pool1.get_extended_symbol()
         && max_asset2.get_extended_symbol() == pool2.get_extended_symbol(), "invalid assets");
 
-    const int64_t liquidity = min(
+    LiquidityChange change;
+    change.liquidity = min(
         GetLiquidity(max_asset1.quantity.amount, supply.amount, raw_pool1_amount),
         GetLiquidity(max_asset2.quantity.amount, supply.amount, raw_pool2_amount)
     );
 
-    extended_asset to_pay1 = pool1;
-    to_pay1.quantity.amount = CalculateToPayAmount(liquidity, raw_pool1_amount, supply.amount);
-    extended_asset to_pay2 = pool2;
-    to_pay2.quantity.amount = CalculateToPayAmount(liquidity, raw_pool2_amount, supply.amount);
+    change.to_pay1 = pool1;
+    change.to_pay1.quantity.amount = CalculateToPayAmount(change.liquidity, raw_pool1_amount, supply.amount);
+    change.to_pay2 = pool2;
+    change.to_pay2.quantity.amount = CalculateToPayAmount(change.liquidity, raw_pool2_amount, supply.amount);
 
-    extended_asset to_add1 = pool1;
-    to_add1.quantity.amount = CalculateToPayAmount(liquidity, pool1.quantity.amount, supply.amount);
-    extended_asset to_add2 = pool2;
-    to_add2.quantity.amount = CalculateToPayAmount(liquidity, pool2.quantity.amount, supply.amount);
+    change.to_pool1 = pool1;
+    change.to_pool1.quantity.amount = CalculateToPayAmount(change.liquidity, pool1.quantity.amount, supply.amount);
+    change.to_pool2 = pool2;
+    change.to_pool2.quantity.amount = CalculateToPayAmount(change.liquidity, pool2.quantity.amount, supply.amount);
 
     // fee calculation
-    const name fee_collector = token_it->fee_contract;
-    const extended_asset fee1 { GetRateOf(to_pay1.quantity.amount, ADD_LIQUIDITY_FEE), to_pay1.get_extended_symbol() };
-    const extended_asset fee2 { GetRateOf(to_pay2.quantity.amount, ADD_LIQUIDITY_FEE), to_pay2.get_extended_symbol() };
+    change.fee1 = {
+        GetRateOf(change.to_pay1.quantity.amount, ADD_LIQUIDITY_FEE),
+        change.to_pay1.get_extended_symbol()
+    };
+    change.fee2 = {
+        GetRateOf(change.to_pay2.quantity.amount, ADD_LIQUIDITY_FEE),
+        change.to_pay2.get_extended_symbol()
+    };
 
-    check(fee1.quantity.amount > 0 && fee2.quantity.amount > 0, "The transaction amount is too small. Trying to use: " +
-        to_pay1.quantity.to_string() + " and " + to_pay2.quantity.to_string() + ". Provided: " +
-        max_asset1.quantity.to_string() + " and " + max_asset2.quantity.to_string());
+    LazyCheck(change.fee1.quantity.amount > 0 && change.fee2.quantity.amount > 0, [&] {
+        return "The transaction amount is too small. Trying to use: " +
+            change.to_pay1.quantity.to_string() + " and " + change.to_pay2.quantity.to_string() + ". Provided: " +
+            max_asset1.quantity.to_string() + " and " + max_asset2.quantity.to_string();
+    });
 
-    // sub user ext balances
-    SubExtBalance(user, to_pay1 + fee1);
-    SubExtBalance(user, to_pay2 + fee2);
+    return change;
+}
 
-    // add balance to user
-    AddBalance(user, { liquidity, token });
+void Contract::ApplyAddLiquidity(CurrencyStatRecord& record, const LiquidityChange& change) {
+    check(MAX_SUPPLY - record.supply.amount >= change.liquidity, "supply overflow");
+    record.supply.amount += change.liquidity;
+    record.pool1 += change.to_pool1;
+    record.pool2 += change.to_pool2;
 
-    // edit pair token params
-    stats_table.modify(token_it, get_self(), [&](CurrencyStatRecord& record) {
-        check(record.max_supply.amount - record.supply.amount >= liquidity, "supply overflow");
-        record.supply.amount += liquidity;
-        record.pool1 += to_add1;
-        record.pool2 += to_add2;
+    record.raw_pool1_amount += change.to_pay1.quantity.amount;
+    record.raw_pool2_amount += change.to_pay2.quantity.amount;
+}
+
+Contract::LiquidityResult Contract::AddLiquiditySingle(const name user, const symbol token, const extended_asset in,
+                                                       const asset min_liquidity,
+                                                       const binary_extension<bool> keep_on_deposit) {
+    require_auth(user);
+
+    check(in.quantity.amount > 0, "in must be positive");
+    check(min_liquidity.symbol.code() == token.code(), "min_liquidity symbol mismatch");
+
+    CurrencyStatsTable stats_table(get_self(), token.code().raw());
+    const auto token_it = stats_table.find(token.code().raw());
+    check (token_it != stats_table.end(), "pair token_it does not exist");
+
+    const extended_symbol in_token = in.get_extended_symbol();
+    const extended_symbol out_token = GetOppositeToken(*token_it, in_token);
+
+    // swap against the pair itself
+    const int64_t swap_amount = CalculateZapAmount(*token_it, in);
+    const SwapHop hop = CalculateSwapByIn(*token_it, { swap_amount, in_token }, out_token);
+
+    // the liquidity is added to the pools after the swap, the add liquidity fee is paid from the same funds
+    CurrencyStatRecord swapped = *token_it;
+    ApplySwap(swapped, hop);
+
+    const extended_asset rest_in = {
+        CalculateAmountWithoutFee(in.quantity.amount - swap_amount, ADD_LIQUIDITY_FEE), in_token
+    };
+    const extended_asset rest_out = {
+        CalculateAmountWithoutFee(hop.out.quantity.amount, ADD_LIQUIDITY_FEE), out_token
+    };
+    const bool in_first = swapped.pool1.get_extended_symbol() == in_token;
+    const LiquidityChange change = in_first
+        ? CalculateAddLiquidity(swapped, rest_in, rest_out)
+        : CalculateAddLiquidity(swapped, rest_out, rest_in);
+    check(change.liquidity >= min_liquidity.amount, "received is less than expected");
+
+    const extended_asset pay_in = in_first ? change.to_pay1 + change.fee1 : change.to_pay2 + change.fee2;
+    const extended_asset pay_out = in_first ? change.to_pay2 + change.fee2 : change.to_pay1 + change.fee1;
 
-        record.raw_pool1_amount += to_pay1.quantity.amount;
-        record.raw_pool2_amount += to_pay2.quantity.amount;
+    const name fee_collector = token_it->fee_contract;
+
+    // sub user ext balance, the swapped out never reaches the deposits
+    SubExtBalance(user, hop.in + hop.fee + pay_in);
+
+    // add balance to user
+    AddBalance(user, { change.liquidity, token });
+
+    // edit pair token params once for the swap and the liquidity
+    ModifyPair(stats_table, token_it, [&](CurrencyStatRecord& record) {
+        ApplySwap(record, hop);
+        ApplyAddLiquidity(record, change);
     });
+    RecordSwapVolume(*token_it, hop);
+    RecordLiquidityVolume(*token_it, change);
 
-    const extended_asset refund1 = Refund(user, to_pay1.get_extended_symbol());
-    const extended_asset refund2 = Refund(user, to_pay2.get_extended_symbol());
+    // transfer change back to user, with keep_on_deposit the deposit stays and the swapped out is added to it
+    const bool keep = keep_on_deposit.value_or(false);
+    const extended_asset refund_in = keep ? extended_asset { 0, in_token } : Refund(user, in_token);
+    const extended_asset refund_out = keep ? extended_asset { 0, out_token } : hop.out - pay_out;
 
-    // transfer change back to user
-    token::transfer_action transfer_pool1_action(to_pay1.contract, { get_self(), "active"_n });
-    token::transfer_action transfer_pool2_action(to_pay2.contract, { get_self(), "active"_n });
-    if (refund1.quantity.amount > 0) {
-        transfer_pool1_action.send(get_self(), user, refund1.quantity, "refund of unused funds");
-    }
-    if (refund2.quantity.amount > 0) {
-        transfer_pool2_action.send(get_self(), user, refund2.quantity, "refund of unused funds");
+    PayOut(user, refund_in, "refund of unused funds", false);
+    PayOut(user, hop.out - pay_out, "refund of unused funds", keep);
+
+    // accrue fee to collector
+    if (hop.fee_collector_share.quantity.amount > 0) {
+        AccrueFee(fee_collector, hop.fee_collector_share);
     }
+    AccrueFee(fee_collector, change.fee1);
+    AccrueFee(fee_collector, change.fee2);
+
+    // "in" is paid in the token of the deposit only, the swapped out is refunded
+    const extended_asset paid_in = hop.in + hop.fee + pay_in;
+    const extended_asset paid_out = { 0, out_token };
+    return {
+        { change.liquidity, token },
+        in_first ? paid_in : paid_out,
+        in_first ? paid_out : paid_in,
+        change.fee1,
+        change.fee2,
+        in_first ? refund_in : refund_out,
+        in_first ? refund_out : refund_in,
+        GetReserves(*token_it)
+    };
+}
+
+// Swapping t of the amount a gives out = g * t * pool_out / pool_in at the linear price of the pair,
+// g = 1 / (1 + fee). Both are added in the ratio of the raw pools after the swap,
+// (a - t) / out = (raw_in + t - s) / (raw_out - out), s the collector share of the fee which does not reach the pool.
+// The t^2 terms cancel: t = a * raw_out / (raw_out + g * (pool_out / pool_in) * (raw_in - s + a)), with s taken at
+// the t for s = 0. The add liquidity fee is paid in the same ratio from both, only the rounding is refunded.
+int64_t Contract::CalculateZapAmount(const CurrencyStatRecord& pair, const extended_asset in) {
+    const bool in_first = pair.pool1.get_extended_symbol() == in.get_extended_symbol();
+    const uint64_t pool_in = (in_first ? pair.pool1 : pair.pool2).quantity.amount;
+    const uint64_t pool_out = (in_first ? pair.pool2 : pair.pool1).quantity.amount;
+    const uint64_t raw_in = in_first ? pair.raw_pool1_amount : pair.raw_pool2_amount;
+    const uint64_t raw_out = in_first ? pair.raw_pool2_amount : pair.raw_pool1_amount;
+    const uint64_t amount = in.quantity.amount;
+
+    check(pool_in > 0 && raw_out > 0, "Insufficient funds in the pool");
+
+    const auto calculate = [&](const uint64_t raw_in_after_share) {
+        const uint64_t priced = MulDivDown(MulDivDown(pool_out, raw_in_after_share + amount, pool_in), MAX_FEE,
+                                           MAX_FEE + pair.fee);
+        const uint64_t divisor = priced > UINT64_MAX_VALUE - raw_out ? UINT64_MAX_VALUE : raw_out + priced;
+        return MulDivDown(amount, raw_out, divisor);
+    };
+
+    const uint64_t estimate = calculate(raw_in);
+    const int64_t collector_share = GetRateOf(
+        GetRateOf(CalculateAmountWithoutFee(int64_t(estimate), pair.fee), pair.fee), pair.fee_contract_rate);
+    const uint64_t swap_amount = calculate(raw_in - min(raw_in, uint64_t(collector_share)));
+
+    check(swap_amount > 0 && swap_amount < amount, "The transaction amount is too small");
 
-    // transfer fee to collector
-    transfer_pool1_action.send(get_self(), fee_collector, fee1.quantity, "add.liquidity fee");
-    transfer_pool2_action.send(get_self(), fee_collector, fee2.quantity, "add.liquidity fee");
+    return int64_t(swap_amount);
 }
 
-void Contract::Swap(const name user, const symbol pair_token, const extended_asset max_in,
-                    const extended_asset expected_out) {
+Contract::SwapResult Contract::Swap(const name user, const symbol pair_token, const extended_asset max_in,
+                                    const extended_asset expected_out,
+                                    const binary_extension<bool> keep_on_deposit) {
     require_auth(user);
 
     CurrencyStatsTable stats_table(get_self(), pair_token.code().raw());
     const auto token_it = stats_table.find(pair_token.code().raw());
     check (token_it != stats_table.end(), "pair token does not exist");
 
-    bool in_first = false;
-    if ((token_it->pool1.get_extended_symbol() == max_in.get_extended_symbol()) &&
-        (token_it->pool2.get_extended_symbol() == expected_out.get_extended_symbol())) {
-        in_first = true;
-    } else {
-        check(
-            token_it->pool1.get_extended_symbol() == expected_out.get_extended_symbol() &&
-            token_it->pool2.get_extended_symbol() == max_in.get_extended_symbol(),
-            "extended_symbol mismatch"
-        );
-    }
+    // "in" calculation
+    const SwapHop hop = CalculateSwapByOut(*token_it, max_in.get_extended_symbol(), expected_out);
+    check(hop.in.quantity.amount <= max_in.quantity.amount, "available is less than expected");
 
-    extended_asset pool_in, pool_out;
-    if (in_first) {
-        pool_in = token_it->pool1;
-        pool_out = token_it->pool2;
-    } else {
-        pool_in = token_it->pool2;
-        pool_out = token_it->pool1;
-    }
+    return SettleSwap(user, stats_table, token_it, hop, keep_on_deposit.value_or(false));
+}
 
-    // "in" calculation
-    const int64_t in = CalculateInAmount(expected_out.quantity.amount, pool_in.quantity.amount,
-                                         pool_out.quantity.amount);
-    check(in <= max_in.quantity.amount, "available is less than expected");
+Contract::SwapResult Contract::SwapIn(const name user, const symbol pair_token, const extended_asset in,
+                                      const extended_asset min_out,
+                                      const binary_extension<bool> keep_on_deposit) {
+    require_auth(user);
 
-    const extended_asset asset_in { in, pool_in.get_extended_symbol() };
-    const extended_asset asset_out = expected_out;
+    check(in.quantity.amount > 0, "in must be positive");
+    check(min_out.quantity.amount >= 0, "min_out must not be negative");
 
-    // fee calculation
-    const int64_t token_fee = token_it->fee;
-    const name fee_collector = token_it->fee_contract;
+    CurrencyStatsTable stats_table(get_self(), pair_token.code().raw());
+    const auto token_it = stats_table.find(pair_token.code().raw());
+    check (token_it != stats_table.end(), "pair token does not exist");
 
-    const int64_t fee_amount = GetRateOf(asset_in.quantity.amount, token_fee);
-    const extended_asset fee { fee_amount, asset_in.get_extended_symbol() };
+    // "out" calculation
+    const SwapHop hop = CalculateSwapByIn(*token_it, in, min_out.get_extended_symbol());
+    check(hop.out.quantity.amount >= min_out.quantity.amount, "received is less than expected");
 
-    const int fee_contract_rate = token_it->fee_contract_rate;
-    const extended_asset fee_collector_share {
-        GetRateOf(fee.quantity.amount, fee_contract_rate),
-        fee.get_extended_symbol()
-    };
+    return SettleSwap(user, stats_table, token_it, hop, keep_on_deposit.value_or(false));
+}
 
-    check(fee.quantity.amount > 0, "The transaction amount is too small");
+Contract::SwapResult Contract::SettleSwap(const name user, CurrencyStatsTable& stats_table,
+                                          const CurrencyStatsTable::const_iterator token_it, const SwapHop& hop,
+                                          const bool keep_on_deposit) {
+    const name fee_collector = token_it->fee_contract;
 
-    // sub ext balance "in + fee"
-    SubExtBalance(user, asset_in + fee);
+    // sub ext balance "in + fee", the deposit row is erased when it is spent completely
+    SubExtBalance(user, hop.in + hop.fee);
 
     // edit pair token params
-    stats_table.modify(token_it, get_self(), [&](CurrencyStatRecord& record) {
-        // limits calculation
-        const int64_t min_pool1_amount = CalculateToPayAmount(
-            record.min_liquidity_amount, record.pool1.quantity.amount, record.supply.amount);
-        const int64_t min_pool2_amount = CalculateToPayAmount(
-            record.min_liquidity_amount, record.pool2.quantity.amount, record.supply.amount);
-
-        const int64_t raw_add = (asset_in + (fee - fee_collector_share)).quantity.amount;
-        if (in_first) {
-            record.pool1 += asset_in;
-            record.raw_pool1_amount += raw_add;
-
-            record.pool2.quantity -= asset_out.quantity;
-            record.raw_pool2_amount -= asset_out.quantity.amount;
-        } else {
-            record.pool2 += asset_in;
-            record.raw_pool2_amount += raw_add;
+    ModifyPair(stats_table, token_it, [&](CurrencyStatRecord& record) {
+        ApplySwap(record, hop);
+    });
+    RecordSwapVolume(*token_it, hop);
+
+    // transfer refund back to user, it stays on deposit with keep_on_deposit
+    const extended_asset refund = keep_on_deposit
+        ? extended_asset { 0, hop.in.get_extended_symbol() }
+        : Refund(user, hop.in.get_extended_symbol());
+    PayOut(user, refund, "refund of unused funds", false);
+
+    // accrue fee to collector
+    if (hop.fee_collector_share.quantity.amount > 0) {
+        AccrueFee(fee_collector, hop.fee_collector_share);
+    }
+
+    // transfer balance "out"
+    PayOut(user, hop.out, "swap", keep_on_deposit);
 
-            record.pool1 -= asset_out;
-            record.raw_pool1_amount -= asset_out.quantity.amount;
+    return { hop, refund, GetReserves(*token_it) };
+}
+
+void Contract::SwapPath(const name user, const vector<symbol> path, const extended_asset in,
+                        const extended_asset out, const bool exact_in) {
+    require_auth(user);
+
+    check(!path.empty(), "path is empty");
+    check(path.size() <= MAX_PATH_LENGTH, "path is too long");
+    check(in.quantity.amount > 0, "in must be positive");
+    check(out.quantity.amount >= 0, "out must not be negative");
+
+    // every pair row is loaded once and kept until the end of the action
+    deque<CurrencyStatsTable> stats_tables;
+    vector<CurrencyStatsTable::const_iterator> pairs;
+    vector<extended_symbol> tokens { in.get_extended_symbol() };
+    pairs.reserve(path.size());
+    tokens.reserve(path.size() + 1);
+
+    for (auto pair_it = path.begin(); pair_it != path.end(); ++pair_it) {
+        // rows are keyed by the code, "4,LP" and "8,LP" are the same pair
+        check(find_if(path.begin(), pair_it, [&](const symbol& previous) {
+            return previous.code() == pair_it->code();
+        }) == pair_it, "pair is used twice in the path");
+
+        CurrencyStatsTable& stats_table = stats_tables.emplace_back(get_self(), pair_it->code().raw());
+        const auto token_it = stats_table.find(pair_it->code().raw());
+        check (token_it != stats_table.end(), "pair token does not exist");
+
+        tokens.push_back(GetOppositeToken(*token_it, tokens.back()));
+        pairs.push_back(token_it);
+    }
+    check(tokens.back() == out.get_extended_symbol(), "path does not end with the out token");
+
+    // intermediate amounts never leave the contract
+    vector<SwapHop> hops(path.size());
+    if (exact_in) {
+        extended_asset amount = in;
+        for (size_t i = 0; i < hops.size(); i++) {
+            hops[i] = CalculateSwapByIn(*pairs[i], amount, tokens[i + 1]);
+            amount = hops[i].out;
+        }
+        check(amount.quantity.amount >= out.quantity.amount, "received is less than expected");
+    } else {
+        extended_asset amount = out;
+        for (size_t i = hops.size(); i-- > 0;) {
+            hops[i] = CalculateSwapByOut(*pairs[i], tokens[i], amount);
+            amount = hops[i].in + hops[i].fee;
         }
+        check(hops.front().in.quantity.amount <= in.quantity.amount, "available is less than expected");
+    }
 
-        check(record.pool1.quantity.amount >= min_pool1_amount && record.pool2.quantity.amount >= min_pool2_amount,
-            "Insufficient funds in the pool");
-    });
+    // sub ext balance "in + fee" of the first hop only
+    SubExtBalance(user, hops.front().in + hops.front().fee);
 
-    const extended_asset refund = Refund(user, asset_in.get_extended_symbol());
+    for (size_t i = 0; i < hops.size(); i++) {
+        ModifyPair(stats_tables[i], pairs[i], [&](CurrencyStatRecord& record) {
+            ApplySwap(record, hops[i]);
+        });
+        RecordSwapVolume(*pairs[i], hops[i]);
+    }
+
+    const extended_asset refund = Refund(user, in.get_extended_symbol());
 
     // transfer refund back to user
-    token::transfer_action transfer_in_action(asset_in.contract, { get_self(), "active"_n });
     if (refund.quantity.amount > 0) {
+        token::transfer_action transfer_in_action(refund.contract, { get_self(), "active"_n });
         transfer_in_action.send(get_self(), user, refund.quantity, "refund of unused funds");
     }
 
-    // transfer fee to collector
-    if (fee_collector_share.quantity.amount > 0) {
-        transfer_in_action.send(get_self(), fee_collector, fee_collector_share.quantity, "swap fee");
+    // accrue fees to collectors
+    for (size_t i = 0; i < hops.size(); i++) {
+        if (hops[i].fee_collector_share.quantity.amount > 0) {
+            AccrueFee(pairs[i]->fee_contract, hops[i].fee_collector_share);
+        }
     }
 
-    // transfer balance "out"
+    // transfer balance "out" of the last hop
+    const extended_asset& asset_out = hops.back().out;
     token::transfer_action transfer_out_action(asset_out.contract, { get_self(), "active"_n });
     transfer_out_action.send(get_self(), user, asset_out.quantity, "swap");
 }
 
-void Contract::RemoveLiquidity(const name user, const asset to_sell, const extended_asset min_asset1,
-                               const extended_asset min_asset2) {
+void Contract::SwapBatch(const name user, const vector<SwapLeg> legs) {
+    require_auth(user);
+
+    check(!legs.empty(), "legs are empty");
+    check(legs.size() <= MAX_BATCH_SIZE, "too many legs");
+
+    // net changes of the user balances and of the collected fees
+    map<extended_symbol, int128_t> balances;
+    map<pair<name, extended_symbol>, int64_t> fees;
+
+    for (const SwapLeg& leg : legs) {
+        CurrencyStatsTable stats_table(get_self(), leg.pair_token.code().raw());
+        const auto token_it = stats_table.find(leg.pair_token.code().raw());
+        check (token_it != stats_table.end(), "pair token does not exist");
+
+        SwapHop hop;
+        if (leg.exact_in) {
+            check(leg.in.quantity.amount > 0, "in must be positive");
+            hop = CalculateSwapByIn(*token_it, leg.in, leg.out.get_extended_symbol());
+            check(hop.out.quantity.amount >= leg.out.quantity.amount, "received is less than expected");
+        } else {
+            hop = CalculateSwapByOut(*token_it, leg.in.get_extended_symbol(), leg.out);
+            check(hop.in.quantity.amount <= leg.in.quantity.amount, "available is less than expected");
+        }
+
+        ModifyPair(stats_table, token_it, [&](CurrencyStatRecord& record) {
+            ApplySwap(record, hop);
+        });
+        RecordSwapVolume(*token_it, hop);
+
+        balances[hop.in.get_extended_symbol()] -= (hop.in + hop.fee).quantity.amount;
+        balances[hop.out.get_extended_symbol()] += hop.out.quantity.amount;
+
+        if (hop.fee_collector_share.quantity.amount > 0) {
+            fees[{ token_it->fee_contract, hop.fee_collector_share.get_extended_symbol() }]
+                += hop.fee_collector_share.quantity.amount;
+        }
+    }
+
+    // settle the net amount of every token, spent tokens are taken from the deposit and received ones are
+    // transferred; the rest of the deposits stays
+    for (const auto& [token, amount] : balances) {
+        check(amount <= asset::max_amount && amount >= -asset::max_amount, "Transaction amount is too large");
+
+        if (amount < 0) {
+            SubExtBalance(user, { static_cast<int64_t>(-amount), token });
+        } else {
+            PayOut(user, { static_cast<int64_t>(amount), token }, "swap", false);
+        }
+    }
+
+    // accrue fees to collectors
+    for (const auto& [key, amount] : fees) {
+        const auto& [fee_collector, token] = key;
+        AccrueFee(fee_collector, { amount, token });
+    }
+}
+
+void Contract::SwapFromMemo(const name from, const extended_asset in, const string& memo) {
+    const vector<string_view> args = SplitMemo(memo, ':');
+    check(args.size() == 3 || args.size() == 4, "invalid memo, expected swap:<pair>:<min_out>[:<recipient>]");
+
+    const symbol_code pair_code { args[1] };
+    const int64_t min_out = ParseAmount(args[2]);
+    const name recipient = args.size() == 4 ? name { args[3] } : from;
+    if (recipient != from) {
+        check(is_account(recipient), "recipient account does not exist");
+    }
+
+    CurrencyStatsTable stats_table(get_self(), pair_code.raw());
+    const auto token_it = stats_table.find(pair_code.raw());
+    check (token_it != stats_table.end(), "pair token does not exist");
+
+    // "out" calculation, the whole transfer is sold
+    const extended_symbol out_token = GetOppositeToken(*token_it, in.get_extended_symbol());
+    const SwapHop hop = CalculateSwapByIn(*token_it, in, out_token);
+    check(hop.out.quantity.amount >= min_out, "received is less than expected");
+
+    const name fee_collector = token_it->fee_contract;
+
+    // edit pair token params
+    ModifyPair(stats_table, token_it, [&](CurrencyStatRecord& record) {
+        ApplySwap(record, hop);
+    });
+    RecordSwapVolume(*token_it, hop);
+
+    // accrue fee to collector
+    if (hop.fee_collector_share.quantity.amount > 0) {
+        AccrueFee(fee_collector, hop.fee_collector_share);
+    }
+
+    // transfer balance "out"
+    token::transfer_action transfer_out_action(hop.out.contract, { get_self(), "active"_n });
+    transfer_out_action.send(get_self(), recipient, hop.out.quantity, "swap");
+}
+
+extended_symbol Contract::GetOppositeToken(const CurrencyStatRecord& pair, const extended_symbol token) {
+    if (pair.pool1.get_extended_symbol() == token) {
+        return pair.pool2.get_extended_symbol();
+    }
+    check(pair.pool2.get_extended_symbol() == token, "extended_symbol mismatch");
+    return pair.pool1.get_extended_symbol();
+}
+
+Contract::SwapHop Contract::CalculateSwapByOut(const CurrencyStatRecord& pair, const extended_symbol in_token,
+                                               const extended_asset expected_out) {
+    check(GetOppositeToken(pair, in_token) == expected_out.get_extended_symbol(), "extended_symbol mismatch");
+
+    const bool in_first = pair.pool1.get_extended_symbol() == in_token;
+    const extended_asset& pool_in = in_first ? pair.pool1 : pair.pool2;
+    const extended_asset& pool_out = in_first ? pair.pool2 : pair.pool1;
+
+    const int64_t in = CalculateInAmount(expected_out.quantity.amount, pool_in.quantity.amount,
+                                         pool_out.quantity.amount);
+
+    SwapHop hop;
+    hop.in = { in, in_token };
+    hop.out = expected_out;
+
+    // fee calculation
+    hop.fee = { GetRateOf(in, pair.fee), in_token };
+    hop.fee_collector_share = { GetRateOf(hop.fee.quantity.amount, pair.fee_contract_rate), in_token };
+
+    check(hop.fee.quantity.amount > 0, "The transaction amount is too small");
+
+    return hop;
+}
+
+Contract::SwapHop Contract::CalculateSwapByIn(const CurrencyStatRecord& pair, const extended_asset total_in,
+                                              const extended_symbol out_token) {
+    check(GetOppositeToken(pair, total_in.get_extended_symbol()) == out_token, "extended_symbol mismatch");
+
+    const bool in_first = pair.pool1.get_extended_symbol() == total_in.get_extended_symbol();
+    const extended_asset& pool_in = in_first ? pair.pool1 : pair.pool2;
+    const extended_asset& pool_out = in_first ? pair.pool2 : pair.pool1;
+
+    // the whole "total_in" is used, the rounding remainder goes to the fee
+    const int64_t in = CalculateAmountWithoutFee(total_in.quantity.amount, pair.fee);
+
+    SwapHop hop;
+    hop.in = { in, total_in.get_extended_symbol() };
+    hop.out = { CalculateOutAmount(in, pool_in.quantity.amount, pool_out.quantity.amount), out_token };
+
+    // fee calculation
+    hop.fee = total_in - hop.in;
+    hop.fee_collector_share = {
+        GetRateOf(GetRateOf(in, pair.fee), pair.fee_contract_rate),
+        total_in.get_extended_symbol()
+    };
+
+    check(hop.fee.quantity.amount > 0 && hop.out.quantity.amount > 0, "The transaction amount is too small");
+
+    return hop;
+}
+
+void Contract::ApplySwap(CurrencyStatRecord& record, const SwapHop& hop) {
+    // limits calculation
+    const int64_t min_pool1_amount = CalculateToPayAmount(
+        record.min_liquidity_amount, record.pool1.quantity.amount, record.supply.amount);
+    const int64_t min_pool2_amount = CalculateToPayAmount(
+        record.min_liquidity_amount, record.pool2.quantity.amount, record.supply.amount);
+
+    const int64_t raw_add = (hop.in + (hop.fee - hop.fee_collector_share)).quantity.amount;
+    if (record.pool1.get_extended_symbol() == hop.in.get_extended_symbol()) {
+        record.pool1 += hop.in;
+        record.raw_pool1_amount += raw_add;
+
+        record.pool2 -= hop.out;
+        record.raw_pool2_amount -= hop.out.quantity.amount;
+    } else {
+        record.pool2 += hop.in;
+        record.raw_pool2_amount += raw_add;
+
+        record.pool1 -= hop.out;
+        record.raw_pool1_amount -= hop.out.quantity.amount;
+    }
+
+    check(record.pool1.quantity.amount >= min_pool1_amount && record.pool2.quantity.amount >= min_pool2_amount,
+        "Insufficient funds in the pool");
+}
+
+int64_t Contract::EstimateSwapOut(const CurrencyStatRecord& pair, const extended_asset total_in) {
+    const bool in_first = pair.pool1.get_extended_symbol() == total_in.get_extended_symbol();
+    const int64_t pool_in_amount = (in_first ? pair.pool1 : pair.pool2).quantity.amount;
+    const int64_t pool_out_amount = (in_first ? pair.pool2 : pair.pool1).quantity.amount;
+    if (pool_in_amount <= 0 || pool_out_amount <= 0 || pair.supply.amount <= 0) {
+        return 0;
+    }
+
+    const int64_t in = CalculateAmountWithoutFee(total_in.quantity.amount, pair.fee);
+    if (in <= 0 || total_in.quantity.amount - in <= 0 || in > asset::max_amount - pool_in_amount) {
+        return 0;
+    }
+
+    // MulDivDown instead of CalculateOutAmount and CalculateToPayAmount, their check on a too large amount would
+    // abort the whole quote instead of dropping this hop
+    const uint64_t out = MulDivDown(uint64_t(in), uint64_t(pool_out_amount), uint64_t(pool_in_amount));
+    if (out == 0 || out > uint64_t(asset::max_amount)) {
+        return 0;
+    }
+
+    // limits of ApplySwap
+    const uint64_t min_pool_in_amount = MulDivDown(uint64_t(pair.min_liquidity_amount), uint64_t(pool_in_amount),
+                                                   uint64_t(pair.supply.amount));
+    const uint64_t min_pool_out_amount = MulDivDown(uint64_t(pair.min_liquidity_amount), uint64_t(pool_out_amount),
+                                                    uint64_t(pair.supply.amount));
+    if (uint64_t(pool_in_amount + in) < min_pool_in_amount || out > uint64_t(pool_out_amount)
+        || uint64_t(pool_out_amount) - out < min_pool_out_amount) {
+        return 0;
+    }
+
+    return int64_t(out);
+}
+
+Contract::LiquidityResult Contract::RemoveLiquidity(const name user, const asset to_sell,
+                                                    const extended_asset min_asset1,
+                                                    const extended_asset min_asset2,
+                                                    const binary_extension<bool> keep_on_deposit) {
     require_auth(user);
 
-    check(to_sell.amount > 0, "to_sell amount must be positive");
     check(min_asset1.quantity.amount > 0 && min_asset2.quantity.amount > 0, "Min assets must positive");
 
     CurrencyStatsTable stats_table(get_self(), to_sell.symbol.code().raw());
     const auto token_it = stats_table.find(to_sell.symbol.code().raw());
     check (token_it != stats_table.end(), "pair token_it does not exist");
 
-    const asset supply = token_it->supply;
-    const extended_asset pool1 = token_it->pool1;
-    const extended_asset pool2 = token_it->pool2;
-    const int64_t raw_pool1_amount = token_it->raw_pool1_amount;
-    const int64_t raw_pool2_amount = token_it->raw_pool2_amount;
-
-    const int64_t liquidity = to_sell.amount;
-
-    extended_asset to_pay1 = pool1;
-    to_pay1.quantity.amount = CalculateToPayAmount(liquidity, raw_pool1_amount, supply.amount);
-    extended_asset to_pay2 = pool2;
-    to_pay2.quantity.amount = CalculateToPayAmount(liquidity, raw_pool2_amount, supply.amount);
-
-    check(to_pay1 >= min_asset1 && to_pay2 >= min_asset2, "available is less than expected");
+    const LiquidityChange change = CalculateRemoveLiquidity(*token_it, to_sell);
 
-    extended_asset to_sub1 = pool1;
-    to_sub1.quantity.amount = CalculateToPayAmount(liquidity, pool1.quantity.amount, supply.amount);
-    extended_asset to_sub2 = pool2;
-    to_sub2.quantity.amount = CalculateToPayAmount(liquidity, pool2.quantity.amount, supply.amount);
+    check(change.to_pay1 >= min_asset1 && change.to_pay2 >= min_asset2, "available is less than expected");
 
     // remove balance from user
     SubBalance(user, to_sell);
 
     // remove supply
-    stats_table.modify(token_it, get_self(), [&](CurrencyStatRecord& record) {
-        record.supply.amount -= liquidity;
-        record.pool1 -= to_sub1;
-        record.pool2 -= to_sub2;
-
-        record.raw_pool1_amount -= to_pay1.quantity.amount;
-        record.raw_pool2_amount -= to_pay2.quantity.amount;
-
-        check(record.supply.amount >= record.min_liquidity_amount,
-            "Insufficient funds in the pool");
+    ModifyPair(stats_table, token_it, [&](CurrencyStatRecord& record) {
+        ApplyRemoveLiquidity(record, change);
     });
+    RecordLiquidityVolume(*token_it, change);
 
     // send funds to user
-    token::transfer_action action1(to_pay1.contract, { get_self(), "active"_n });
-    action1.send(get_self(), user, to_pay1.quantity, "removed liquidity");
+    PayOut(user, change.to_pay1, "removed liquidity", keep_on_deposit.value_or(false));
+    PayOut(user, change.to_pay2, "removed liquidity", keep_on_deposit.value_or(false));
+
+    return {
+        to_sell,
+        change.to_pay1,
+        change.to_pay2,
+        change.fee1,
+        change.fee2,
+        { 0, change.to_pay1.get_extended_symbol() },
+        { 0, change.to_pay2.get_extended_symbol() },
+        GetReserves(*token_it)
+    };
+}
+
+Contract::LiquidityChange Contract::CalculateRemoveLiquidity(const CurrencyStatRecord& pair, const asset to_sell) {
+    check(to_sell.amount > 0, "to_sell amount must be positive");
+
+    const asset supply = pair.supply;
+    const extended_asset pool1 = pair.pool1;
+    const extended_asset pool2 = pair.pool2;
+    const int64_t raw_pool1_amount = pair.raw_pool1_amount;
+    const int64_t raw_pool2_amount = pair.raw_pool2_amount;
+
+    LiquidityChange change;
+    change.liquidity = to_sell.amount;
+
+    change.to_pay1 = pool1;
+    change.to_pay1.quantity.amount = CalculateToPayAmount(change.liquidity, raw_pool1_amount, supply.amount);
+    change.to_pay2 = pool2;
+    change.to_pay2.quantity.amount = CalculateToPayAmount(change.liquidity, raw_pool2_amount, supply.amount);
+
+    change.to_pool1 = pool1;
+    change.to_pool1.quantity.amount = CalculateToPayAmount(change.liquidity, pool1.quantity.amount, supply.amount);
+    change.to_pool2 = pool2;
+    change.to_pool2.quantity.amount = CalculateToPayAmount(change.liquidity, pool2.quantity.amount, supply.amount);
+
+    change.fee1 = { 0, pool1.get_extended_symbol() };
+    change.fee2 = { 0, pool2.get_extended_symbol() };
+
+    return change;
+}
+
+void Contract::ApplyRemoveLiquidity(CurrencyStatRecord& record, const LiquidityChange& change) {
+    record.supply.amount -= change.liquidity;
+    record.pool1 -= change.to_pool1;
+    record.pool2 -= change.to_pool2;
+
+    record.raw_pool1_amount -= change.to_pay1.quantity.amount;
+    record.raw_pool2_amount -= change.to_pay2.quantity.amount;
+
+    check(record.supply.amount >= record.min_liquidity_amount,
+        "Insufficient funds in the pool");
+}
 
-    token::transfer_action action2(to_pay2.contract, { get_self(), "active"_n });
-    action2.send(get_self(), user, to_pay2.quantity, "removed liquidity");
+Contract::PairReserves Contract::GetReserves(const CurrencyStatRecord& pair) {
+    return { pair.pool1, pair.pool2, pair.raw_pool1_amount, pair.raw_pool2_amount, pair.supply };
 }
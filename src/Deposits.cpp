@@ -1,5 +1,7 @@
 #include <Contract.hpp>
 #include <eosio.token.hpp>
+#include <Util.hpp>
+#include <map>
 
 using namespace std;
 using namespace eosio;
@@ -18,22 +20,14 @@ void Contract::OnTokenDeposit(name from, name to, asset quantity, const string&
 
     const extended_asset ext_asset { quantity, get_first_receiver() };
     check(ext_asset.quantity.is_valid(), "invalid asset");
+    check(IsTokenAccepted(ext_asset.get_extended_symbol()), "token is not accepted");
 
-    DepositsTable balances_table {get_self(), from.value };
-    auto index = balances_table.get_index<"extended"_n>();
-
-    const auto balance_it = index.find(GetIndexFromToken(ext_asset.get_extended_symbol()));
-
-    if (balance_it == index.end()) {
-        balances_table.emplace(get_self(), [&](DepositRecord& record) {
-            record.id = balances_table.available_primary_key();
-            record.balance = ext_asset;
-        });
-    } else {
-        index.modify(balance_it, get_self(), [&](DepositRecord& record) {
-            record.balance += ext_asset;
-        });
+    if (memo.rfind("swap:", 0) == 0) {
+        SwapFromMemo(from, ext_asset, memo);
+        return;
     }
+
+    AddExtBalance(from, ext_asset);
 }
 
 void Contract::OnEosTokenDeposit(name from, name to, asset quantity, const string& memo) {
@@ -44,31 +38,70 @@ uint128_t Contract::GetIndexFromToken(const extended_symbol token) {
     return (static_cast<uint128_t>(token.get_contract().value) << 64) + token.get_symbol().raw();
 }
 
+uint64_t Contract::GetKeyFromToken(const extended_symbol token) {
+    // 64-bit finalizer of murmur3, the top bit is dropped so probing never wraps around
+    uint64_t key = token.get_contract().value ^ (token.get_symbol().raw() * 0x9e3779b97f4a7c15);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccd;
+    key ^= key >> 33;
+
+    return key >> 1;
+}
+
+Contract::DepositsTable::const_iterator Contract::FindOrMigrateDeposit(DepositsTable& deposits,
+                                                                       const extended_symbol token) {
+    const auto deposit_it = FindByToken(deposits, token);
+    if (deposit_it != deposits.end()) {
+        return deposit_it;
+    }
+
+    // once the scope has no legacy rows left, misses cost one primary lookup instead of the secondary index
+    LegacyDepositsTable legacy_deposits { get_self(), deposits.get_scope() };
+    if (legacy_deposits.begin() == legacy_deposits.end()) {
+        return deposits.end();
+    }
+    auto index = legacy_deposits.get_index<"extended"_n>();
+
+    const auto legacy_it = index.find(GetIndexFromToken(token));
+    if (legacy_it == index.end()) {
+        return deposits.end();
+    }
+
+    const extended_asset balance = legacy_it->balance;
+    index.erase(legacy_it);
+
+    return EmplaceDeposit(deposits, balance);
+}
+
+Contract::DepositsTable::const_iterator Contract::EmplaceDeposit(DepositsTable& deposits,
+                                                                 const extended_asset balance) {
+    return EmplaceByToken(deposits, balance.get_extended_symbol(), [&](DepositRecord& record) {
+        record.balance = balance;
+    });
+}
+
 void Contract::AddExtBalance(const name user, const extended_asset to_add) {
     check(to_add.quantity.is_valid(), "invalid asset");
 
     DepositsTable balances {get_self(), user.value };
-    auto index = balances.get_index<"extended"_n>();
 
-    const auto balance_it = index.find(GetIndexFromToken(to_add.get_extended_symbol()));
+    const auto balance_it = FindOrMigrateDeposit(balances, to_add.get_extended_symbol());
 
-    if (balance_it == index.end()) {
+    if (balance_it == balances.end()) {
         check(to_add.quantity.amount > 0, "Insufficient funds");
 
-        balances.emplace(get_self(), [&](DepositRecord& record) {
-            record.id = balances.available_primary_key();
-            record.balance = to_add;
-        });
+        EmplaceDeposit(balances, to_add);
     } else {
         if (balance_it->balance.quantity.amount + to_add.quantity.amount == 0) {
-            index.erase(balance_it);
+            balances.erase(balance_it);
             return;
         }
 
-        index.modify(balance_it, get_self(), [&](DepositRecord& record) {
-            check(to_add.quantity.amount + record.balance.quantity.amount >= 0,
-                  "Insufficient funds, you have " + record.balance.quantity.to_string()
-                  + ", but need " + (to_add.quantity * -1).to_string());
+        balances.modify(balance_it, get_self(), [&](DepositRecord& record) {
+            LazyCheck(to_add.quantity.amount + record.balance.quantity.amount >= 0, [&] {
+                return "Insufficient funds, you have " + record.balance.quantity.to_string()
+                    + ", but need " + (to_add.quantity * -1).to_string();
+            });
 
             record.balance += to_add;
         });
@@ -79,7 +112,7 @@ void Contract::SubExtBalance(const name user, const extended_asset value) {
     AddExtBalance(user, -value);
 }
 
-void Contract::Withdraw(const name user, const extended_symbol token) {
+extended_asset Contract::Withdraw(const name user, const extended_symbol token) {
     require_auth(user);
 
     const extended_asset to_transfer = Refund(user, token);
@@ -87,20 +120,121 @@ void Contract::Withdraw(const name user, const extended_symbol token) {
 
     token::transfer_action transfer_action(to_transfer.contract, { get_self(), "active"_n });
     transfer_action.send(get_self(), user, to_transfer.quantity, "withdraw");
+
+    return to_transfer;
+}
+
+vector<extended_asset> Contract::WithdrawAll(const name user, const uint32_t max_rows) {
+    require_auth(user);
+
+    // balances of the same token in both tables are paid with one transfer
+    map<extended_symbol, int64_t> balances;
+    uint32_t erased = 0;
+
+    DepositsTable deposits { get_self(), user.value };
+    for (auto deposit_it = deposits.begin(); deposit_it != deposits.end() && (max_rows == 0 || erased < max_rows);
+         erased++) {
+        balances[deposit_it->balance.get_extended_symbol()] += deposit_it->balance.quantity.amount;
+        deposit_it = deposits.erase(deposit_it);
+    }
+
+    LegacyDepositsTable legacy_deposits { get_self(), user.value };
+    for (auto legacy_it = legacy_deposits.begin();
+         legacy_it != legacy_deposits.end() && (max_rows == 0 || erased < max_rows); erased++) {
+        balances[legacy_it->balance.get_extended_symbol()] += legacy_it->balance.quantity.amount;
+        legacy_it = legacy_deposits.erase(legacy_it);
+    }
+
+    vector<extended_asset> to_transfer;
+    to_transfer.reserve(balances.size());
+    for (const auto& [token, amount] : balances) {
+        to_transfer.push_back({ amount, token });
+    }
+    SendWithdrawals(user, to_transfer);
+
+    return to_transfer;
+}
+
+vector<extended_asset> Contract::WithdrawTokens(const name user, const vector<extended_symbol> tokens) {
+    require_auth(user);
+    check(tokens.size() <= MAX_BATCH_SIZE, "too many tokens");
+
+    vector<extended_asset> to_transfer;
+    to_transfer.reserve(tokens.size());
+    for (const extended_symbol& token : tokens) {
+        to_transfer.push_back(Refund(user, token));
+    }
+    SendWithdrawals(user, to_transfer);
+
+    return to_transfer;
+}
+
+void Contract::SendWithdrawals(const name user, const vector<extended_asset>& to_transfer) {
+    bool withdrawn = false;
+
+    for (const extended_asset& balance : to_transfer) {
+        if (balance.quantity.amount <= 0) {
+            continue;
+        }
+        withdrawn = true;
+
+        token::transfer_action transfer_action(balance.contract, { get_self(), "active"_n });
+        transfer_action.send(get_self(), user, balance.quantity, "withdraw");
+    }
+
+    check(withdrawn, "There is nothing to withdraw");
+}
+
+void Contract::PayOut(const name user, const extended_asset value, const string& memo, const bool keep_on_deposit) {
+    if (value.quantity.amount <= 0) {
+        return;
+    }
+    if (keep_on_deposit) {
+        AddExtBalance(user, value);
+        return;
+    }
+
+    token::transfer_action transfer_action(value.contract, { get_self(), "active"_n });
+    transfer_action.send(get_self(), user, value.quantity, memo);
 }
 
 extended_asset Contract::Refund(const name user, const extended_symbol token) {
     DepositsTable balances_table { get_self(), user.value };
-    auto index = balances_table.get_index<"extended"_n>();
 
-    const auto balance_it = index.find(GetIndexFromToken(token));
+    const auto balance_it = FindOrMigrateDeposit(balances_table, token);
 
-    if (balance_it == index.end()) {
+    if (balance_it == balances_table.end()) {
         return { 0, token };
     }
 
     const extended_asset to_exchange = balance_it->balance;
-    index.erase(balance_it);
+    balances_table.erase(balance_it);
 
     return max(to_exchange, { 0, token });
 }
+
+void Contract::MigrateDeposits(const name user, const uint32_t max_rows) {
+    check(has_auth(user) || has_auth(get_self()), "missing authority of user or contract");
+    check(max_rows > 0, "max_rows must be positive");
+
+    LegacyDepositsTable legacy_deposits { get_self(), user.value };
+    check(legacy_deposits.begin() != legacy_deposits.end(), "There is nothing to migrate");
+
+    DepositsTable deposits { get_self(), user.value };
+
+    uint32_t migrated = 0;
+    for (auto legacy_it = legacy_deposits.begin(); legacy_it != legacy_deposits.end() && migrated < max_rows;
+         migrated++) {
+        const extended_asset balance = legacy_it->balance;
+        legacy_it = legacy_deposits.erase(legacy_it);
+
+        const auto deposit_it = FindByToken(deposits, balance.get_extended_symbol());
+        if (deposit_it == deposits.end()) {
+            EmplaceDeposit(deposits, balance);
+        } else {
+            deposits.modify(deposit_it, get_self(), [&](DepositRecord& record) {
+                record.balance += balance;
+            });
+        }
+    }
+}
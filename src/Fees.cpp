@@ -0,0 +1,36 @@
+#include <Contract.hpp>
+#include <eosio.token.hpp>
+
+using namespace std;
+using namespace eosio;
+
+void Contract::AccrueFee(const name collector, const extended_asset fee) {
+    check(fee.quantity.is_valid(), "invalid asset");
+
+    FeesTable fees { get_self(), collector.value };
+    const auto fee_it = FindByToken(fees, fee.get_extended_symbol());
+
+    if (fee_it == fees.end()) {
+        EmplaceByToken(fees, fee.get_extended_symbol(), [&](FeeRecord& record) {
+            record.balance = fee;
+        });
+    } else {
+        fees.modify(fee_it, get_self(), [&](FeeRecord& record) {
+            record.balance += fee;
+        });
+    }
+}
+
+void Contract::ClaimFees(const name collector) {
+    require_auth(collector);
+
+    FeesTable fees { get_self(), collector.value };
+    check(fees.begin() != fees.end(), "There is nothing to claim");
+
+    for (auto fee_it = fees.begin(); fee_it != fees.end();) {
+        const extended_asset to_transfer = fee_it->balance;
+        fee_it = fees.erase(fee_it);
+
+        PayOut(collector, to_transfer, "claimed fees", false);
+    }
+}
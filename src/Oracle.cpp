@@ -0,0 +1,102 @@
+#include <Contract.hpp>
+#include <Math.hpp>
+
+using namespace std;
+using namespace eosio;
+
+bool Contract::AccumulatePrice(CurrencyStatRecord& record, const uint32_t now) {
+    const uint32_t last_update = record.last_update;
+    if (now <= last_update) {
+        return false;
+    }
+    record.last_update = now;
+
+    // rows written before the accumulators start from now
+    if (last_update == 0) {
+        return true;
+    }
+
+    const int64_t pool1_amount = record.pool1.quantity.amount;
+    const int64_t pool2_amount = record.pool2.quantity.amount;
+    if (pool1_amount > 0 && pool2_amount > 0) {
+        const uint32_t elapsed = now - last_update;
+        record.price1_cumulative += DivideToQ64(pool2_amount, pool1_amount) * elapsed;
+        record.price2_cumulative += DivideToQ64(pool1_amount, pool2_amount) * elapsed;
+    }
+
+    return now / TWAP_OBSERVATION_PERIOD != last_update / TWAP_OBSERVATION_PERIOD;
+}
+
+void Contract::RecordObservation(const CurrencyStatRecord& record) {
+    ObservationsTable observations { get_self(), record.supply.symbol.code().raw() };
+    const uint64_t slot = (record.last_update / TWAP_OBSERVATION_PERIOD) % TWAP_OBSERVATIONS;
+
+    const auto write = [&](ObservationRecord& observation) {
+        observation.slot = slot;
+        observation.time = record.last_update;
+        observation.price1_cumulative = record.price1_cumulative;
+        observation.price2_cumulative = record.price2_cumulative;
+    };
+
+    const auto observation_it = observations.find(slot);
+    if (observation_it == observations.end()) {
+        observations.emplace(get_self(), write);
+    } else {
+        observations.modify(observation_it, get_self(), write);
+    }
+}
+
+void Contract::RemoveObservations(const symbol_code pair_code) {
+    ObservationsTable observations { get_self(), pair_code.raw() };
+
+    for (auto observation_it = observations.begin(); observation_it != observations.end();) {
+        observation_it = observations.erase(observation_it);
+    }
+}
+
+Contract::PriceTwap Contract::QuoteTwap(const symbol_code pair_code, const uint32_t window) {
+    check(window <= (TWAP_OBSERVATIONS - 1) * TWAP_OBSERVATION_PERIOD, "window is longer than the observations");
+
+    CurrencyStatsTable stats_table(get_self(), pair_code.raw());
+    const auto token_it = stats_table.find(pair_code.raw());
+    check (token_it != stats_table.end(), "pair token does not exist");
+
+    // accumulators as if the pair was updated now
+    const uint32_t now = current_time_point().sec_since_epoch();
+    CurrencyStatRecord record = *token_it;
+    AccumulatePrice(record, now);
+
+    PriceTwap result;
+    result.end = { time_point_sec { now }, record.price1_cumulative, record.price2_cumulative };
+
+    if (window == 0) {
+        result.start = result.end;
+        result.price1 = DivideToQ64(record.pool2.quantity.amount, record.pool1.quantity.amount);
+        result.price2 = DivideToQ64(record.pool1.quantity.amount, record.pool2.quantity.amount);
+        return result;
+    }
+
+    // the observation of the period of "now - window", or of the closest earlier period with an update
+    ObservationsTable observations { get_self(), pair_code.raw() };
+    const uint32_t start_period = (now - window) / TWAP_OBSERVATION_PERIOD;
+    auto observation_it = observations.end();
+    for (uint32_t period = start_period; period + TWAP_OBSERVATIONS > start_period && period > 0; period--) {
+        const auto slot_it = observations.find(period % TWAP_OBSERVATIONS);
+        if (slot_it != observations.end() && slot_it->time / TWAP_OBSERVATION_PERIOD == period
+            && slot_it->time <= now - window) {
+            observation_it = slot_it;
+            break;
+        }
+    }
+    check(observation_it != observations.end(), "no observation for the window");
+
+    result.start = {
+        time_point_sec { observation_it->time }, observation_it->price1_cumulative, observation_it->price2_cumulative
+    };
+
+    const uint32_t elapsed = now - observation_it->time;
+    result.price1 = DivideBy64(result.end.price1_cumulative - result.start.price1_cumulative, elapsed);
+    result.price2 = DivideBy64(result.end.price2_cumulative - result.start.price2_cumulative, elapsed);
+
+    return result;
+}
@@ -0,0 +1,68 @@
+#include <Contract.hpp>
+
+using namespace std;
+using namespace eosio;
+
+checksum256 Contract::GetIndexFromTokens(const extended_symbol token1, const extended_symbol token2) {
+    const uint128_t index1 = GetIndexFromToken(token1);
+    const uint128_t index2 = GetIndexFromToken(token2);
+
+    return checksum256 { array<uint128_t, 2> { min(index1, index2), max(index1, index2) } };
+}
+
+void Contract::AddPairToDirectory(const symbol token, const extended_symbol token1, const extended_symbol token2) {
+    PairsTable pairs { get_self(), get_self().value };
+
+    pairs.emplace(get_self(), [&](PairRecord& record) {
+        record.token = token;
+        record.token1 = token1;
+        record.token2 = token2;
+    });
+
+    ChangeTokenPairs(token1, 1);
+    ChangeTokenPairs(token2, 1);
+}
+
+void Contract::RemovePairFromDirectory(const symbol token) {
+    PairsTable pairs { get_self(), get_self().value };
+
+    const auto pair_it = pairs.find(token.code().raw());
+    if (pair_it != pairs.end()) {
+        ChangeTokenPairs(pair_it->token1, -1);
+        ChangeTokenPairs(pair_it->token2, -1);
+        pairs.erase(pair_it);
+    }
+}
+
+void Contract::IndexPairs(const vector<symbol_code> pair_codes) {
+    require_auth(get_self());
+
+    PairsTable pairs { get_self(), get_self().value };
+
+    for (const symbol_code& pair_code : pair_codes) {
+        if (pairs.find(pair_code.raw()) != pairs.end()) {
+            continue;
+        }
+
+        CurrencyStatsTable stats_table(get_self(), pair_code.raw());
+        const auto token_it = stats_table.find(pair_code.raw());
+        check (token_it != stats_table.end(), "pair token does not exist");
+
+        AddPairToDirectory(token_it->supply.symbol, token_it->pool1.get_extended_symbol(),
+                           token_it->pool2.get_extended_symbol());
+    }
+}
+
+void Contract::MigratePairs(const vector<symbol_code> pair_codes) {
+    require_auth(get_self());
+    check(!pair_codes.empty() && pair_codes.size() <= MAX_BATCH_SIZE, "invalid number of pairs");
+
+    for (const symbol_code& pair_code : pair_codes) {
+        CurrencyStatsTable stats_table(get_self(), pair_code.raw());
+        const auto token_it = stats_table.find(pair_code.raw());
+        check (token_it != stats_table.end(), "pair token does not exist");
+
+        // the row is read by operator>> and written back in the current layout
+        stats_table.modify(token_it, get_self(), [](CurrencyStatRecord&) {});
+    }
+}
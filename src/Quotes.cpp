@@ -0,0 +1,207 @@
+#include <Contract.hpp>
+#include <Util.hpp>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+using namespace eosio;
+
+vector<Contract::SwapQuote> Contract::QuoteSwap(const vector<SwapLeg> requests) {
+    vector<SwapQuote> result;
+    result.reserve(requests.size());
+
+    for (const SwapLeg& request : requests) {
+        CurrencyStatsTable stats_table(get_self(), request.pair_token.code().raw());
+        const auto token_it = stats_table.find(request.pair_token.code().raw());
+        check (token_it != stats_table.end(), "pair token does not exist");
+
+        SwapQuote quote;
+        quote.hop = request.exact_in
+            ? CalculateSwapByIn(*token_it, request.in, request.out.get_extended_symbol())
+            : CalculateSwapByOut(*token_it, request.in.get_extended_symbol(), request.out);
+
+        // the same checks as swap, applied to a copy
+        CurrencyStatRecord record = *token_it;
+        ApplySwap(record, quote.hop);
+
+        const extended_asset& pool_out = token_it->pool1.get_extended_symbol() == quote.hop.out.get_extended_symbol()
+            ? token_it->pool1 : token_it->pool2;
+        const int64_t min_pool_out_amount = CalculateToPayAmount(
+            token_it->min_liquidity_amount, pool_out.quantity.amount, token_it->supply.amount);
+        quote.max_out = { pool_out.quantity.amount - min_pool_out_amount, pool_out.get_extended_symbol() };
+
+        result.push_back(quote);
+    }
+
+    return result;
+}
+
+vector<Contract::LiquidityQuote> Contract::QuoteAddLiquidity(const vector<AddLiquidityRequest> requests) {
+    vector<LiquidityQuote> result;
+    result.reserve(requests.size());
+
+    for (const AddLiquidityRequest& request : requests) {
+        CurrencyStatsTable stats_table(get_self(), request.token.code().raw());
+        const auto token_it = stats_table.find(request.token.code().raw());
+        check (token_it != stats_table.end(), "pair token_it does not exist");
+
+        const LiquidityChange change = CalculateAddLiquidity(*token_it, request.max_asset1, request.max_asset2);
+
+        // the same checks as addliquidity, applied to a copy
+        CurrencyStatRecord record = *token_it;
+        ApplyAddLiquidity(record, change);
+
+        result.push_back({
+            { change.liquidity, token_it->supply.symbol },
+            change.to_pay1 + change.fee1,
+            change.to_pay2 + change.fee2,
+            change.fee1,
+            change.fee2,
+            { token_it->min_liquidity_amount, token_it->supply.symbol }
+        });
+    }
+
+    return result;
+}
+
+vector<Contract::LiquidityQuote> Contract::QuoteRemoveLiquidity(const vector<asset> requests) {
+    vector<LiquidityQuote> result;
+    result.reserve(requests.size());
+
+    for (const asset& to_sell : requests) {
+        CurrencyStatsTable stats_table(get_self(), to_sell.symbol.code().raw());
+        const auto token_it = stats_table.find(to_sell.symbol.code().raw());
+        check (token_it != stats_table.end(), "pair token_it does not exist");
+
+        const LiquidityChange change = CalculateRemoveLiquidity(*token_it, to_sell);
+
+        // the same checks as remliquidity, applied to a copy
+        CurrencyStatRecord record = *token_it;
+        ApplyRemoveLiquidity(record, change);
+
+        result.push_back({
+            to_sell,
+            change.to_pay1,
+            change.to_pay2,
+            change.fee1,
+            change.fee2,
+            { token_it->min_liquidity_amount, token_it->supply.symbol }
+        });
+    }
+
+    return result;
+}
+
+vector<Contract::RouteQuote> Contract::QuoteRoute(const extended_asset in, const extended_symbol out_token,
+                                                  const uint8_t max_hops) {
+    check(in.quantity.amount > 0, "in must be positive");
+    check(in.get_extended_symbol() != out_token, "extended symbols must be different");
+    check(max_hops > 0 && max_hops <= MAX_PATH_LENGTH, "invalid max_hops");
+
+    PairsTable pairs { get_self(), get_self().value };
+    auto token1_index = pairs.get_index<"token1"_n>();
+    auto token2_index = pairs.get_index<"token2"_n>();
+
+    // the pairs of every token and every pair row are read once
+    map<uint128_t, vector<pair<symbol, extended_symbol>>> edges;
+    map<uint64_t, CurrencyStatRecord> records;
+
+    const auto get_edges = [&](const extended_symbol& token) -> const vector<pair<symbol, extended_symbol>>& {
+        const uint128_t key = GetIndexFromToken(token);
+        const auto edges_it = edges.find(key);
+        if (edges_it != edges.end()) {
+            return edges_it->second;
+        }
+
+        vector<pair<symbol, extended_symbol>>& result = edges[key];
+        for (auto pair_it = token1_index.lower_bound(key); pair_it != token1_index.end()
+             && pair_it->token1_key() == key; ++pair_it) {
+            result.emplace_back(pair_it->token, pair_it->token2);
+        }
+        for (auto pair_it = token2_index.lower_bound(key); pair_it != token2_index.end()
+             && pair_it->token2_key() == key; ++pair_it) {
+            result.emplace_back(pair_it->token, pair_it->token1);
+        }
+        return result;
+    };
+
+    const auto get_record = [&](const symbol& pair_token) -> const CurrencyStatRecord& {
+        const auto record_it = records.find(pair_token.code().raw());
+        if (record_it != records.end()) {
+            return record_it->second;
+        }
+
+        CurrencyStatsTable stats_table(get_self(), pair_token.code().raw());
+        const auto token_it = stats_table.find(pair_token.code().raw());
+        check (token_it != stats_table.end(), "pair token does not exist");
+
+        return records.emplace(pair_token.code().raw(), *token_it).first->second;
+    };
+
+    struct Route {
+        vector<symbol> path;
+        vector<extended_symbol> tokens;
+        extended_asset amount;
+    };
+
+    // amounts reaching a token by routes of the same or fewer hops, a route is dropped
+    // when ROUTE_RESULTS of them are not smaller
+    map<uint128_t, vector<int64_t>> reached;
+
+    vector<RouteQuote> result;
+    vector<Route> routes { { {}, { in.get_extended_symbol() }, in } };
+    uint32_t evaluations = 0;
+
+    for (uint8_t hops = 0; hops < max_hops && !routes.empty(); hops++) {
+        vector<Route> next_routes;
+
+        for (const Route& route : routes) {
+            for (const auto& [pair_token, token] : get_edges(route.tokens.back())) {
+                if (find(route.tokens.begin(), route.tokens.end(), token) != route.tokens.end()) {
+                    continue;
+                }
+                if (evaluations == MAX_ROUTE_EVALUATIONS) {
+                    break;
+                }
+                evaluations++;
+
+                const int64_t out = EstimateSwapOut(get_record(pair_token), route.amount);
+                if (out <= 0) {
+                    continue;
+                }
+
+                Route next = route;
+                next.path.push_back(pair_token);
+                next.tokens.push_back(token);
+                next.amount = { out, token };
+
+                if (token == out_token) {
+                    result.push_back({ next.path, next.amount });
+                    continue;
+                }
+
+                vector<int64_t>& amounts = reached[GetIndexFromToken(token)];
+                const auto better = count_if(amounts.begin(), amounts.end(), [&](const int64_t amount) {
+                    return amount >= out;
+                });
+                if (better >= ROUTE_RESULTS) {
+                    continue;
+                }
+                amounts.push_back(out);
+                next_routes.push_back(move(next));
+            }
+        }
+
+        routes = move(next_routes);
+    }
+
+    // shorter routes are found first and stay ahead of equal amounts
+    stable_sort(result.begin(), result.end(), [](const RouteQuote& a, const RouteQuote& b) {
+        return a.out.quantity.amount > b.out.quantity.amount;
+    });
+    if (result.size() > ROUTE_RESULTS) {
+        result.resize(ROUTE_RESULTS);
+    }
+
+    return result;
+}
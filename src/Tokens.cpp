@@ -0,0 +1,129 @@
+#include <Contract.hpp>
+
+using namespace std;
+using namespace eosio;
+
+bool Contract::IsTokenAccepted(const extended_symbol token) const {
+    const TokensTable tokens { get_self(), get_self().value };
+
+    return FindByToken(tokens, token) != tokens.end();
+}
+
+void Contract::ChangeTokenPairs(const extended_symbol token, const int32_t change) {
+    TokensTable tokens { get_self(), get_self().value };
+
+    const auto token_it = FindByToken(tokens, token);
+    if (token_it == tokens.end()) {
+        if (change > 0) {
+            EmplaceByToken(tokens, token, [&](TokenRecord& record) {
+                record.token = token;
+                record.pairs = change;
+            });
+        }
+        return;
+    }
+
+    const uint32_t pairs = change < 0 && token_it->pairs < uint32_t(-change) ? 0 : token_it->pairs + change;
+    if (pairs == 0 && !token_it->allowed) {
+        tokens.erase(token_it);
+        return;
+    }
+
+    tokens.modify(token_it, get_self(), [&](TokenRecord& record) {
+        record.pairs = pairs;
+    });
+}
+
+void Contract::AllowToken(const extended_symbol token, const bool allowed) {
+    require_auth(get_self());
+
+    TokensTable tokens { get_self(), get_self().value };
+
+    const auto token_it = FindByToken(tokens, token);
+    if (token_it == tokens.end()) {
+        check(allowed, "token is not accepted");
+
+        EmplaceByToken(tokens, token, [&](TokenRecord& record) {
+            record.token = token;
+            record.allowed = true;
+        });
+        return;
+    }
+
+    if (!allowed && token_it->pairs == 0) {
+        tokens.erase(token_it);
+        return;
+    }
+
+    tokens.modify(token_it, get_self(), [&](TokenRecord& record) {
+        record.allowed = allowed;
+    });
+}
+
+void Contract::IndexTokens(const vector<extended_symbol> tokens) {
+    require_auth(get_self());
+
+    PairsTable pairs { get_self(), get_self().value };
+    auto token1_index = pairs.get_index<"token1"_n>();
+    auto token2_index = pairs.get_index<"token2"_n>();
+
+    for (const extended_symbol& token : tokens) {
+        const uint128_t key = GetIndexFromToken(token);
+
+        int32_t count = 0;
+        for (auto pair_it = token1_index.lower_bound(key); pair_it != token1_index.end() && pair_it->token1 == token;
+             ++pair_it) {
+            count++;
+        }
+        for (auto pair_it = token2_index.lower_bound(key); pair_it != token2_index.end() && pair_it->token2 == token;
+             ++pair_it) {
+            count++;
+        }
+
+        // the recount replaces the stored number
+        TokensTable tokens_table { get_self(), get_self().value };
+        const auto token_it = FindByToken(tokens_table, token);
+        const int32_t stored = token_it == tokens_table.end() ? 0 : int32_t(token_it->pairs);
+        if (count != stored) {
+            ChangeTokenPairs(token, count - stored);
+        }
+    }
+}
+
+void Contract::CleanDeposits(const name user, const uint32_t max_rows, const bool refund) {
+    require_auth(get_self());
+    check(max_rows > 0, "max_rows must be positive");
+
+    vector<extended_asset> erased;
+
+    DepositsTable deposits { get_self(), user.value };
+    for (auto deposit_it = deposits.begin(); deposit_it != deposits.end() && erased.size() < max_rows;) {
+        if (IsTokenAccepted(deposit_it->balance.get_extended_symbol())) {
+            ++deposit_it;
+            continue;
+        }
+        erased.push_back(deposit_it->balance);
+        deposit_it = deposits.erase(deposit_it);
+    }
+
+    LegacyDepositsTable legacy_deposits { get_self(), user.value };
+    for (auto legacy_it = legacy_deposits.begin();
+         legacy_it != legacy_deposits.end() && erased.size() < max_rows;) {
+        if (IsTokenAccepted(legacy_it->balance.get_extended_symbol())) {
+            ++legacy_it;
+            continue;
+        }
+        erased.push_back(legacy_it->balance);
+        legacy_it = legacy_deposits.erase(legacy_it);
+    }
+
+    check(!erased.empty(), "There is nothing to clean");
+
+    // without refund a token contract which rejects the transfer cannot block the cleanup
+    if (!refund) {
+        return;
+    }
+    for (const extended_asset& balance : erased) {
+        PayOut(user, balance, "refund of a token which is not accepted", false);
+    }
+}
@@ -0,0 +1,105 @@
+#include <Contract.hpp>
+
+#include <limits>
+
+using namespace std;
+using namespace eosio;
+
+void Contract::AddVolume(VolumeStats& total, const VolumeStats& value) {
+    const auto add = [](auto& sum, const auto amount) {
+        const auto max_value = numeric_limits<remove_reference_t<decltype(sum)>>::max();
+        sum = sum > max_value - amount ? max_value : sum + amount;
+    };
+
+    add(total.volume1_in, value.volume1_in);
+    add(total.volume1_out, value.volume1_out);
+    add(total.volume2_in, value.volume2_in);
+    add(total.volume2_out, value.volume2_out);
+    add(total.fee1, value.fee1);
+    add(total.fee2, value.fee2);
+    add(total.trades, value.trades);
+    add(total.liquidity_changes, value.liquidity_changes);
+}
+
+void Contract::RecordVolume(const symbol_code pair_code, const VolumeStats& change) {
+    VolumesTable volumes { get_self(), pair_code.raw() };
+    const uint32_t period = current_time_point().sec_since_epoch() / VOLUME_BUCKET_PERIOD;
+    const uint64_t slot = period % VOLUME_BUCKETS;
+
+    const auto volume_it = volumes.find(slot);
+    if (volume_it == volumes.end()) {
+        volumes.emplace(get_self(), [&](VolumeRecord& record) {
+            record.slot = slot;
+            record.period = period;
+            record.stats = change;
+        });
+        return;
+    }
+
+    volumes.modify(volume_it, get_self(), [&](VolumeRecord& record) {
+        if (record.period != period) {
+            record.period = period;
+            record.stats = {};
+        }
+        AddVolume(record.stats, change);
+    });
+}
+
+void Contract::RecordSwapVolume(const CurrencyStatRecord& pair, const SwapHop& hop) {
+    VolumeStats change;
+    change.trades = 1;
+
+    if (pair.pool1.get_extended_symbol() == hop.in.get_extended_symbol()) {
+        change.volume1_in = hop.in.quantity.amount;
+        change.fee1 = hop.fee.quantity.amount;
+        change.volume2_out = hop.out.quantity.amount;
+    } else {
+        change.volume2_in = hop.in.quantity.amount;
+        change.fee2 = hop.fee.quantity.amount;
+        change.volume1_out = hop.out.quantity.amount;
+    }
+
+    RecordVolume(pair.supply.symbol.code(), change);
+}
+
+void Contract::RecordLiquidityVolume(const CurrencyStatRecord& pair, const LiquidityChange& change) {
+    VolumeStats volume;
+    volume.liquidity_changes = 1;
+    volume.fee1 = change.fee1.quantity.amount;
+    volume.fee2 = change.fee2.quantity.amount;
+
+    RecordVolume(pair.supply.symbol.code(), volume);
+}
+
+void Contract::RemoveVolumes(const symbol_code pair_code) {
+    VolumesTable volumes { get_self(), pair_code.raw() };
+
+    for (auto volume_it = volumes.begin(); volume_it != volumes.end();) {
+        volume_it = volumes.erase(volume_it);
+    }
+}
+
+Contract::VolumeQuote Contract::QuoteVolume(const symbol_code pair_code, const uint32_t window) {
+    check(window < VOLUME_BUCKETS * VOLUME_BUCKET_PERIOD, "window is longer than the buckets");
+
+    CurrencyStatsTable stats_table(get_self(), pair_code.raw());
+    check (stats_table.find(pair_code.raw()) != stats_table.end(), "pair token does not exist");
+
+    const uint32_t now = current_time_point().sec_since_epoch();
+    const uint32_t start_period = (now > window ? now - window : 0) / VOLUME_BUCKET_PERIOD;
+    const uint32_t end_period = now / VOLUME_BUCKET_PERIOD;
+
+    VolumeQuote result;
+    result.start = time_point_sec { start_period * VOLUME_BUCKET_PERIOD };
+    result.end = time_point_sec { now };
+
+    VolumesTable volumes { get_self(), pair_code.raw() };
+    for (uint32_t period = start_period; period <= end_period; period++) {
+        const auto volume_it = volumes.find(period % VOLUME_BUCKETS);
+        if (volume_it != volumes.end() && volume_it->period == period) {
+            AddVolume(result.stats, volume_it->stats);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,186 @@
+#include <Decoder.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace eosio;
+
+// Decodes a delta file of two blocks encoded by hand after the state history ABI: table_delta v0 and v1, a delta of
+// another table, a row of another contract and a removed row, and checks every decoded column, the column file
+// header and that truncated input is rejected. Exits with 1 on a difference.
+namespace {
+
+const name SELF = "agora.dex"_n;
+const name OTHER = "other.dex"_n;
+const name ALICE = "alice"_n;
+
+uint32_t failures = 0;
+
+void Expect(const bool condition, const string& what) {
+    if (!condition) {
+        printf("failed: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+// little endian integers and varuint32 prefixed bytes, as in the state history ABI
+class Bytes {
+public:
+    Bytes& Byte(const uint8_t value) {
+        data.push_back(char(value));
+        return *this;
+    }
+
+    Bytes& UInt64(uint64_t value) {
+        for (int i = 0; i < 8; i++, value >>= 8) {
+            Byte(uint8_t(value & 0xFF));
+        }
+        return *this;
+    }
+
+    Bytes& UInt32(uint32_t value) {
+        for (int i = 0; i < 4; i++, value >>= 8) {
+            Byte(uint8_t(value & 0xFF));
+        }
+        return *this;
+    }
+
+    Bytes& VarUInt32(uint32_t value) {
+        do {
+            Byte(uint8_t((value & 0x7F) | (value > 0x7F ? 0x80 : 0)));
+            value >>= 7;
+        } while (value != 0);
+        return *this;
+    }
+
+    Bytes& String(const string& value) {
+        VarUInt32(uint32_t(value.size()));
+        data.insert(data.end(), value.begin(), value.end());
+        return *this;
+    }
+
+    Bytes& Blob(const vector<char>& value) {
+        VarUInt32(uint32_t(value.size()));
+        data.insert(data.end(), value.begin(), value.end());
+        return *this;
+    }
+
+    vector<char> data;
+};
+
+// row of a table_delta: bool present, bytes of contract_row_v0
+vector<char> ContractRow(const name code, const uint64_t scope, const name table, const uint64_t primary_key,
+                         const vector<char>& value) {
+    return Bytes {}.VarUInt32(0).UInt64(code.value).UInt64(scope).UInt64(table.value).UInt64(primary_key)
+        .UInt64(code.value).Blob(value).data;
+}
+
+const symbol TOKEN { symbol_code { "TKN" }, 4 };
+const symbol PAIR_TOKEN { symbol_code { "LPAB" }, 4 };
+const extended_symbol TOKEN1 { symbol { symbol_code { "AAA" }, 4 }, "token.a"_n };
+const extended_symbol TOKEN2 { symbol { symbol_code { "BBB" }, 8 }, "token.b"_n };
+
+vector<char> MakeDeltaFile() {
+    // accounts row: asset { int64 amount, uint64 symbol }
+    const vector<char> balance = Bytes {}.UInt64(12345).UInt64(TOKEN.raw()).data;
+    const vector<char> removed_balance = Bytes {}.UInt64(0).UInt64(TOKEN.raw()).data;
+    // depositsv2 row: uint64 key, extended_asset { int64 amount, uint64 symbol, uint64 contract }
+    const vector<char> deposit = Bytes {}.UInt64(777).UInt64(500).UInt64(TOKEN1.get_symbol().raw())
+        .UInt64(TOKEN1.get_contract().value).data;
+    const vector<char> pair = host::TableDecoder::EncodePair(asset { 1000, PAIR_TOKEN }, { 2000, TOKEN1 },
+                                                             { 3000, TOKEN2 }, 2010, 3020, 300000);
+
+    Bytes first;
+    first.VarUInt32(2);
+    first.VarUInt32(0).String("account").VarUInt32(1);
+    first.Byte(1).Blob({ 'a', 'b', 'c' });
+    first.VarUInt32(0).String("contract_row").VarUInt32(4);
+    first.Byte(1).Blob(ContractRow(SELF, ALICE.value, "accounts"_n, TOKEN.code().raw(), balance));
+    first.Byte(1).Blob(ContractRow(SELF, ALICE.value, "depositsv2"_n, 777, deposit));
+    first.Byte(1).Blob(ContractRow(OTHER, ALICE.value, "accounts"_n, TOKEN.code().raw(), balance));
+    first.Byte(1).Blob(ContractRow(SELF, PAIR_TOKEN.code().raw(), "stat"_n, PAIR_TOKEN.code().raw(), pair));
+
+    Bytes second;
+    second.VarUInt32(1);
+    second.VarUInt32(1).String("contract_row").VarUInt32(1);
+    second.Byte(0).Blob(ContractRow(SELF, ALICE.value, "accounts"_n, TOKEN.code().raw(), removed_balance));
+
+    Bytes file;
+    file.UInt32(uint32_t(first.data.size()));
+    file.data.insert(file.data.end(), first.data.begin(), first.data.end());
+    file.UInt32(uint32_t(second.data.size()));
+    file.data.insert(file.data.end(), second.data.begin(), second.data.end());
+    return file.data;
+}
+
+void CheckColumns(const host::TableDecoder& decoder) {
+    Expect(decoder.GetDecoded() == 4, "decoded rows");
+    Expect(decoder.GetSkipped() == 2, "skipped rows");
+
+    const host::BalanceColumns& balances = decoder.GetBalances();
+    Expect(balances.amount == vector<int64_t> { 12345, 0 }, "accounts.amount");
+    Expect(balances.symbol == vector<uint64_t> { TOKEN.raw(), TOKEN.raw() }, "accounts.symbol");
+    Expect(balances.scope == vector<uint64_t> { ALICE.value, ALICE.value }, "accounts.scope");
+    Expect(balances.present == vector<uint8_t> { 1, 0 }, "accounts.present");
+    Expect(balances.sequence == vector<uint64_t> { 0, 1 }, "accounts.sequence");
+
+    const host::DepositColumns& deposits = decoder.GetDeposits();
+    Expect(deposits.primary == vector<uint64_t> { 777 }, "deposits.primary");
+    Expect(deposits.amount == vector<int64_t> { 500 }, "deposits.amount");
+    Expect(deposits.symbol == vector<uint64_t> { TOKEN1.get_symbol().raw() }, "deposits.symbol");
+    Expect(deposits.contract == vector<uint64_t> { TOKEN1.get_contract().value }, "deposits.contract");
+    Expect(deposits.legacy == vector<uint8_t> { 0 }, "deposits.legacy");
+
+    const host::PairColumns& pairs = decoder.GetPairs();
+    Expect(pairs.scope == vector<uint64_t> { PAIR_TOKEN.code().raw() }, "stat.scope");
+    Expect(pairs.supply == vector<int64_t> { 1000 }, "stat.supply");
+    Expect(pairs.pool1 == vector<int64_t> { 2000 } && pairs.pool2 == vector<int64_t> { 3000 }, "stat.pool");
+    Expect(pairs.pool2_symbol == vector<uint64_t> { TOKEN2.get_symbol().raw() }, "stat.pool2_symbol");
+    Expect(pairs.pool2_contract == vector<uint64_t> { TOKEN2.get_contract().value }, "stat.pool2_contract");
+    Expect(pairs.raw_pool1 == vector<int64_t> { 2010 } && pairs.raw_pool2 == vector<int64_t> { 3020 },
+           "stat.raw_pool");
+    Expect(pairs.fee == vector<int64_t> { 300000 }, "stat.fee");
+}
+
+void CheckColumnFile(const host::TableDecoder& decoder, const string& path) {
+    Expect(decoder.WriteColumns(path), "column file written");
+
+    ifstream input { path, ios::binary };
+    char magic[8] = {};
+    uint32_t count = 0;
+    input.read(magic, sizeof(magic));
+    input.read(reinterpret_cast<char*>(&count), sizeof(count));
+    Expect(input && memcmp(magic, "DEXCOLS1", sizeof(magic)) == 0 && count == 28, "column file header");
+}
+
+}
+
+int main(int argc, char** argv) {
+    const string path = argc > 1 ? argv[1] : "decoded.cols";
+    const vector<char> file = MakeDeltaFile();
+
+    host::TableDecoder decoder { SELF };
+    decoder.DecodeDeltaFile(file.data(), file.size());
+    CheckColumns(decoder);
+    CheckColumnFile(decoder, path);
+
+    bool rejected = false;
+    try {
+        host::TableDecoder truncated { SELF };
+        truncated.DecodeDeltaFile(file.data(), file.size() - 1);
+    } catch (const runtime_error&) {
+        rejected = true;
+    }
+    Expect(rejected, "truncated delta file is rejected");
+
+    if (failures > 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("deltas decoded as encoded\n");
+    return 0;
+}
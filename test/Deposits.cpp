@@ -0,0 +1,312 @@
+#include <Fixture.hpp>
+#include <Decoder.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+using namespace eosio;
+using namespace host::fixture;
+
+// Places deposit rows of other tokens at the hashed key of a token on the host chain and checks that its deposit
+// probes to the next free key and fails after MAX_KEY_PROBES taken keys, runs migrate.dep over legacy rows in chunks
+// and withdraw.all and withdraw.sym over deposits of both layouts. Exits with 1 on a difference.
+namespace {
+
+const name ALICE = "alice"_n;
+const name BOB = "bob"_n;
+
+// new chain where TKA, TKB and TKC are accepted
+host::Dex Start() {
+    host::Chain::Get().Reset();
+    host::Dex dex { SELF };
+    for (const name account : { ALICE, BOB }) {
+        host::Chain::Get().AddAccount(account.value);
+    }
+
+    for (const char* code : { "TKA", "TKB", "TKC" }) {
+        string error;
+        const bool allowed = dex.Run({ SELF }, [&](Contract& contract) {
+            contract.AllowToken(Token(code, 0).get_extended_symbol(), true);
+        }, &error);
+        Expect(allowed, "token.allow " + error);
+    }
+    return dex;
+}
+
+// rows of "table" in the scope of "user", the deposit tables of both layouts start with the uint64 key
+// followed by the balance
+vector<pair<uint64_t, extended_asset>> GetDepositRows(const host::Dex& dex, const name table, const name user) {
+    vector<pair<uint64_t, extended_asset>> rows;
+    for (const host::SnapshotRow& row : dex.GetRows()) {
+        if (row.table == table && row.scope == user.value) {
+            rows.push_back(unpack<pair<uint64_t, extended_asset>>(row.data));
+        }
+    }
+    return rows;
+}
+
+// key of the deposit row of "token", 0 if there is none
+uint64_t GetDepositKey(const host::Dex& dex, const name user, const extended_symbol& token) {
+    for (const auto& [key, balance] : GetDepositRows(dex, "depositsv2"_n, user)) {
+        if (balance.get_extended_symbol() == token) {
+            return key;
+        }
+    }
+    return 0;
+}
+
+// deposits of other tokens at "key" and the following keys
+bool LoadCollisions(host::Dex& dex, const uint64_t key, const uint32_t first, const uint32_t count) {
+    vector<host::SnapshotRow> rows;
+    for (uint32_t i = first; i < first + count; i++) {
+        const string code = string("TX") + char('A' + i);
+        rows.push_back({ "depositsv2"_n, ALICE.value, SELF,
+                         host::TableDecoder::EncodeDeposit(key + i, Token(code.c_str(), 1)) });
+    }
+
+    string error;
+    const bool loaded = dex.LoadRows(rows, &error);
+    Expect(loaded, "rows at the taken keys " + error);
+    return loaded;
+}
+
+void CheckKeyCollisions() {
+    host::Dex dex = Start();
+    const extended_asset deposit = Token("TKA", 10000);
+
+    Expect(dex.Deposit(TOKEN_CONTRACT, ALICE, deposit.quantity), "deposit of alice");
+    const uint64_t key = GetDepositKey(dex, ALICE, deposit.get_extended_symbol());
+    Expect(key != 0, "key of the deposit");
+    Expect(dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.Withdraw(ALICE, deposit.get_extended_symbol());
+    }), "withdraw of alice");
+
+    // the first probes found taken, the deposit goes to the next free key and is found there
+    uint32_t loaded = 0;
+    for (const uint32_t taken : { uint32_t(1), uint32_t(MAX_KEY_PROBES - 1) }) {
+        if (!LoadCollisions(dex, key, loaded, taken - loaded)) {
+            return;
+        }
+        loaded = taken;
+
+        string error;
+        const bool deposited = dex.Deposit(TOKEN_CONTRACT, ALICE, deposit.quantity, "", &error)
+            && dex.Deposit(TOKEN_CONTRACT, ALICE, deposit.quantity, "", &error);
+        Expect(deposited, "deposits with " + to_string(taken) + " taken keys " + error);
+        Expect(GetDepositKey(dex, ALICE, deposit.get_extended_symbol()) == key + taken,
+               "deposit at the free key after " + to_string(taken) + " taken keys");
+        Expect(dex.GetDeposit(ALICE, deposit.get_extended_symbol()) == deposit + deposit,
+               "deposit after " + to_string(taken) + " taken keys");
+
+        const bool withdrawn = dex.Run({ ALICE }, [&](Contract& contract) {
+            contract.Withdraw(ALICE, deposit.get_extended_symbol());
+        }, &error);
+        const vector<host::Transfer> transfers = dex.GetTransfers();
+        Expect(withdrawn && transfers.size() == 1 && transfers[0].quantity == (deposit + deposit).quantity,
+               "withdraw after " + to_string(taken) + " taken keys " + error);
+    }
+
+    // no free key within MAX_KEY_PROBES
+    if (!LoadCollisions(dex, key, loaded, 1)) {
+        return;
+    }
+    string error;
+    const bool deposited = dex.Deposit(TOKEN_CONTRACT, ALICE, deposit.quantity, "", &error);
+    Expect(!deposited && error.find("too many key collisions") != string::npos,
+           "deposit with " + to_string(MAX_KEY_PROBES) + " taken keys fails: " + error);
+    Expect(GetDepositRows(dex, "depositsv2"_n, ALICE).size() == MAX_KEY_PROBES, "rows after the failed deposit");
+}
+
+// legacy rows are moved in order of their id and added to the deposits of the same token
+void CheckMigrateDeposits() {
+    host::Dex dex = Start();
+    Expect(dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 50).quantity), "deposit of alice");
+
+    // the legacy row has the same layout with an auto-increment id
+    string error;
+    const bool loaded = dex.LoadRows({
+        { "deposits"_n, ALICE.value, SELF, host::TableDecoder::EncodeDeposit(0, Token("TKA", 100)) },
+        { "deposits"_n, ALICE.value, SELF, host::TableDecoder::EncodeDeposit(1, Token("TKB", 200)) },
+        { "deposits"_n, ALICE.value, SELF, host::TableDecoder::EncodeDeposit(2, Token("TKC", 300)) },
+    }, &error);
+    Expect(loaded, "legacy rows " + error);
+
+    Expect(!dex.Run({ BOB }, [&](Contract& contract) {
+        contract.MigrateDeposits(ALICE, 1);
+    }), "migrate.dep of alice authorized by bob fails");
+    Expect(!dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.MigrateDeposits(ALICE, 0);
+    }), "migrate.dep of 0 rows fails");
+
+    const bool first = dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.MigrateDeposits(ALICE, 2);
+    }, &error);
+    Expect(first, "migrate.dep of 2 rows " + error);
+    Expect(GetDepositRows(dex, "deposits"_n, ALICE).size() == 1, "legacy row left after migrate.dep of 2 rows");
+    Expect(dex.GetDeposit(ALICE, Token("TKA", 0).get_extended_symbol()) == Token("TKA", 150), "merged TKA deposit");
+    Expect(dex.GetDeposit(ALICE, Token("TKB", 0).get_extended_symbol()) == Token("TKB", 200), "migrated TKB deposit");
+
+    const bool second = dex.Run({ SELF }, [&](Contract& contract) {
+        contract.MigrateDeposits(ALICE, 10);
+    }, &error);
+    Expect(second, "migrate.dep by the contract " + error);
+    Expect(GetDepositRows(dex, "deposits"_n, ALICE).empty(), "no legacy rows after migrate.dep");
+    Expect(GetDepositRows(dex, "depositsv2"_n, ALICE).size() == 3, "deposit rows after migrate.dep");
+    Expect(dex.GetDeposit(ALICE, Token("TKC", 0).get_extended_symbol()) == Token("TKC", 300), "migrated TKC deposit");
+
+    const bool third = dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.MigrateDeposits(ALICE, 10);
+    }, &error);
+    Expect(!third && error.find("There is nothing to migrate") != string::npos, "migrate.dep without rows fails");
+}
+
+// assets of different symbols are not comparable
+bool SameAsset(const extended_asset& asset1, const extended_asset& asset2) {
+    return asset1.get_extended_symbol() == asset2.get_extended_symbol()
+        && asset1.quantity.amount == asset2.quantity.amount;
+}
+
+// "values" are "expected" in any order
+bool SameAssets(const vector<extended_asset>& values, const vector<extended_asset>& expected) {
+    return values.size() == expected.size() && all_of(values.begin(), values.end(), [&](const extended_asset& value) {
+        return any_of(expected.begin(), expected.end(), [&](const extended_asset& expected_value) {
+            return SameAsset(value, expected_value);
+        });
+    });
+}
+
+// the transfers of the last action are "expected" to alice, in any order
+void ExpectTransfers(const host::Dex& dex, const vector<extended_asset>& expected, const string& what) {
+    vector<extended_asset> transferred;
+    bool to_alice = true;
+    for (const host::Transfer& transfer : dex.GetTransfers()) {
+        transferred.push_back({ transfer.quantity, transfer.contract });
+        to_alice = to_alice && transfer.to == ALICE;
+    }
+    Expect(to_alice && SameAssets(transferred, expected), "transfers of " + what);
+}
+
+bool LoadLegacyDeposits(host::Dex& dex, const vector<extended_asset>& balances) {
+    vector<host::SnapshotRow> rows;
+    for (uint64_t id = 0; id < balances.size(); id++) {
+        rows.push_back({ "deposits"_n, ALICE.value, SELF, host::TableDecoder::EncodeDeposit(id, balances[id]) });
+    }
+
+    string error;
+    const bool loaded = dex.LoadRows(rows, &error);
+    Expect(loaded, "legacy rows " + error);
+    return loaded;
+}
+
+// balances of a token in both tables are paid with one transfer
+void CheckWithdrawAll() {
+    host::Dex dex = Start();
+    for (const extended_asset& deposit : { Token("TKA", 100), Token("TKB", 200) }) {
+        Expect(dex.Deposit(deposit.contract, ALICE, deposit.quantity), "deposit of alice");
+    }
+    if (!LoadLegacyDeposits(dex, { Token("TKA", 50), Token("TKC", 300) })) {
+        return;
+    }
+
+    Expect(!dex.Run({ BOB }, [&](Contract& contract) {
+        contract.WithdrawAll(ALICE, 0);
+    }), "withdraw.all of alice authorized by bob fails");
+
+    vector<extended_asset> withdrawn;
+    string error;
+    const bool all = dex.Run({ ALICE }, [&](Contract& contract) {
+        withdrawn = contract.WithdrawAll(ALICE, 0);
+    }, &error);
+    Expect(all, "withdraw.all without a limit " + error);
+    const vector<extended_asset> expected { Token("TKA", 150), Token("TKB", 200), Token("TKC", 300) };
+    ExpectTransfers(dex, expected, "withdraw.all without a limit");
+    Expect(SameAssets(withdrawn, expected), "returned balances of withdraw.all");
+    Expect(GetDepositRows(dex, "depositsv2"_n, ALICE).empty() && GetDepositRows(dex, "deposits"_n, ALICE).empty(),
+           "no rows after withdraw.all");
+
+    // max_rows counts the rows of both tables
+    for (const extended_asset& deposit : { Token("TKA", 100), Token("TKB", 200) }) {
+        Expect(dex.Deposit(deposit.contract, ALICE, deposit.quantity), "deposit of alice");
+    }
+    if (!LoadLegacyDeposits(dex, { Token("TKC", 300) })) {
+        return;
+    }
+    for (const size_t rows : { 2, 1 }) {
+        const bool limited = dex.Run({ ALICE }, [&](Contract& contract) {
+            withdrawn = contract.WithdrawAll(ALICE, 2);
+        }, &error);
+        Expect(limited && withdrawn.size() == rows && dex.GetTransfers().size() == rows,
+               "withdraw.all of at most 2 rows " + error);
+    }
+    Expect(GetDepositRows(dex, "depositsv2"_n, ALICE).empty() && GetDepositRows(dex, "deposits"_n, ALICE).empty(),
+           "no rows after withdraw.all of at most 2 rows");
+
+    const bool empty = dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.WithdrawAll(ALICE, 0);
+    }, &error);
+    Expect(!empty && error.find("There is nothing to withdraw") != string::npos, "withdraw.all without rows fails");
+}
+
+// tokens without a deposit are skipped, a legacy deposit is found through the legacy table
+void CheckWithdrawTokens() {
+    host::Dex dex = Start();
+    for (const extended_asset& deposit : { Token("TKA", 100), Token("TKC", 300) }) {
+        Expect(dex.Deposit(deposit.contract, ALICE, deposit.quantity), "deposit of alice");
+    }
+    const extended_symbol tka = Token("TKA", 0).get_extended_symbol();
+    const extended_symbol tkb = Token("TKB", 0).get_extended_symbol();
+    const extended_symbol tkc = Token("TKC", 0).get_extended_symbol();
+
+    Expect(!dex.Run({ BOB }, [&](Contract& contract) {
+        contract.WithdrawTokens(ALICE, { tka });
+    }), "withdraw.sym of alice authorized by bob fails");
+
+    vector<extended_asset> withdrawn;
+    string error;
+    const bool listed = dex.Run({ ALICE }, [&](Contract& contract) {
+        withdrawn = contract.WithdrawTokens(ALICE, { tka, tkb, tkc });
+    }, &error);
+    Expect(listed, "withdraw.sym " + error);
+    ExpectTransfers(dex, { Token("TKA", 100), Token("TKC", 300) }, "withdraw.sym");
+    Expect(withdrawn.size() == 3 && withdrawn[0] == Token("TKA", 100) && withdrawn[1] == Token("TKB", 0)
+           && withdrawn[2] == Token("TKC", 300), "returned balances of withdraw.sym");
+    Expect(GetDepositRows(dex, "depositsv2"_n, ALICE).empty(), "no rows after withdraw.sym");
+
+    const bool missing = dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.WithdrawTokens(ALICE, { tkb });
+    }, &error);
+    Expect(!missing && error.find("There is nothing to withdraw") != string::npos,
+           "withdraw.sym without deposits fails");
+
+    if (LoadLegacyDeposits(dex, { Token("TKB", 200) })) {
+        const bool legacy = dex.Run({ ALICE }, [&](Contract& contract) {
+            withdrawn = contract.WithdrawTokens(ALICE, { tkb });
+        }, &error);
+        Expect(legacy, "withdraw.sym of a legacy deposit " + error);
+        ExpectTransfers(dex, { Token("TKB", 200) }, "withdraw.sym of a legacy deposit");
+        Expect(GetDepositRows(dex, "deposits"_n, ALICE).empty(), "no legacy rows after withdraw.sym");
+    }
+
+    const bool too_many = dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.WithdrawTokens(ALICE, vector<extended_symbol>(MAX_BATCH_SIZE + 1, tka));
+    }, &error);
+    Expect(!too_many && error.find("too many tokens") != string::npos, "withdraw.sym of too many tokens fails");
+}
+
+}
+
+int main() {
+    CheckKeyCollisions();
+    CheckMigrateDeposits();
+    CheckWithdrawAll();
+    CheckWithdrawTokens();
+
+    if (failures > 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("deposits match the contract\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <Fixture.hpp>
+#include <Util.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+using namespace eosio;
+using namespace host::fixture;
+
+// Runs a pair creation, swaps, a failed and an unauthorized action and transfer.many on the host chain and checks
+// the tables and the captured transfers against the pricing of the contract. Exits with 1 on a difference.
+namespace {
+
+const name ALICE = "alice"_n;
+const name BOB = "bob"_n;
+const name CAROL = "carol"_n;
+
+void CheckCreatePair(host::Dex& dex) {
+    string error;
+    const bool created = CreatePair(dex, Token("TKA", 1000000000), Token("TKB", 2000000000), PAIR_CODE, &error);
+    Expect(created, "create.pair " + error);
+
+    const auto record = dex.GetPair(PAIR_CODE);
+    Expect(record.has_value(), "pair row");
+    if (record) {
+        Expect(record->pool1 == Token("TKA", 1000000000) && record->pool2 == Token("TKB", 2000000000), "pools");
+        Expect(dex.GetBalance(ISSUER, PAIR_TOKEN).amount > 0, "liquidity of the issuer");
+    }
+
+    const bool added = AddLiquidity(dex, ISSUER, Token("TKA", 1000000000), Token("TKB", 2000000000), PAIR_TOKEN,
+                                    &error);
+    Expect(added, "addliquidity " + error);
+}
+
+// the whole deposit is sold for in * pool_out / pool_in of the part without the fee
+void CheckSwapIn(host::Dex& dex) {
+    const auto before = *dex.GetPair(PAIR_CODE);
+    const int64_t in = CalculateAmountWithoutFee(100000, PAIR_FEE);
+    const int64_t expected_out = CalculateOutAmount(in, before.pool1.quantity.amount, before.pool2.quantity.amount);
+
+    Expect(dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 100000).quantity), "deposit of alice");
+    string error;
+    const bool swapped = dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.SwapIn(ALICE, PAIR_TOKEN, Token("TKA", 100000), Token("TKB", 0), {});
+    }, &error);
+    Expect(swapped, "swap.in " + error);
+
+    const vector<host::Transfer> transfers = dex.GetTransfers();
+    Expect(transfers.size() == 1, "one transfer of swap.in");
+#ifdef DEX_INSTRUMENTATION
+    const host::ActionMetrics& metrics = dex.GetMetrics();
+    Expect(metrics.inline_actions == 1, "inline actions of swap.in");
+    Expect(metrics.OfTable("stat").reads >= 1 && metrics.OfTable("stat").modifies >= 1, "stat operations of swap.in");
+    Expect(metrics.Total().bytes_written > 0, "bytes written by swap.in");
+#endif
+    if (!transfers.empty()) {
+        Expect(transfers[0].to == ALICE && transfers[0].quantity == Token("TKB", expected_out).quantity,
+               "out of swap.in");
+    }
+
+    const auto after = *dex.GetPair(PAIR_CODE);
+    Expect(after.pool1.quantity.amount == before.pool1.quantity.amount + in, "pool in after swap.in");
+    Expect(after.pool2.quantity.amount == before.pool2.quantity.amount - expected_out, "pool out after swap.in");
+    Expect(dex.GetDeposit(ALICE, Token("TKA", 0).get_extended_symbol()).quantity.amount == 0, "deposit is sold");
+}
+
+// a failed check reverts every change of the action
+void CheckRevert(host::Dex& dex) {
+    Expect(dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 100000).quantity), "deposit of alice");
+    const auto before = *dex.GetPair(PAIR_CODE);
+
+    string error;
+    Expect(!dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.Swap(ALICE, PAIR_TOKEN, Token("TKA", 100000), Token("TKB", 1000000000), {});
+    }, &error), "swap above the deposit fails");
+    Expect(!error.empty(), "message of the failed swap");
+
+    const auto after = *dex.GetPair(PAIR_CODE);
+    Expect(after.pool1 == before.pool1 && after.pool2 == before.pool2, "pools after the failed swap");
+    Expect(dex.GetDeposit(ALICE, Token("TKA", 0).get_extended_symbol()).quantity.amount == 100000,
+           "deposit after the failed swap");
+}
+
+void CheckAuthorization(host::Dex& dex) {
+    Expect(!dex.Run({ BOB }, [&](Contract& contract) {
+        contract.Withdraw(ALICE, Token("TKA", 0).get_extended_symbol());
+    }), "withdraw of alice authorized by bob fails");
+    Expect(dex.GetDeposit(ALICE, Token("TKA", 0).get_extended_symbol()).quantity.amount == 100000,
+           "deposit after the unauthorized withdraw");
+
+    Expect(dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.Withdraw(ALICE, Token("TKA", 0).get_extended_symbol());
+    }), "withdraw of alice");
+    const vector<host::Transfer> transfers = dex.GetTransfers();
+    Expect(transfers.size() == 1 && transfers[0].to == ALICE && transfers[0].quantity == Token("TKA", 100000).quantity,
+           "transfer of the withdraw");
+}
+
+// the sender is debited once for the total and every recipient is credited and notified, without inline actions
+void CheckTransferMany(host::Dex& dex) {
+    const asset sent = dex.GetBalance(ISSUER, PAIR_TOKEN);
+    const asset to_bob { sent.amount / 4, PAIR_TOKEN };
+    const asset to_carol { sent.amount / 8, PAIR_TOKEN };
+
+    string error;
+    const bool transferred = dex.Run({ ISSUER }, [&](Contract& contract) {
+        contract.TransferMany(ISSUER, { { BOB, to_bob, "lp" }, { CAROL, to_carol, "lp" } });
+    }, &error);
+    Expect(transferred, "transfer.many " + error);
+
+    Expect(dex.GetBalance(ISSUER, PAIR_TOKEN) == sent - to_bob - to_carol, "balance of the sender");
+    Expect(dex.GetBalance(BOB, PAIR_TOKEN) == to_bob, "balance of the first recipient");
+    Expect(dex.GetBalance(CAROL, PAIR_TOKEN) == to_carol, "balance of the second recipient");
+    Expect(host::Chain::Get().GetInlineActions().empty(), "no inline actions of transfer.many");
+
+    const vector<uint64_t>& recipients = host::Chain::Get().GetRecipients();
+    for (const name account : { ISSUER, BOB, CAROL }) {
+        Expect(find(recipients.begin(), recipients.end(), account.value) != recipients.end(),
+               "notification of " + account.to_string());
+    }
+
+    Expect(!dex.Run({ ISSUER }, [&](Contract& contract) {
+        contract.TransferMany(ISSUER, { { BOB, to_bob, "" }, { BOB, to_bob, "" } });
+    }), "transfer.many to a duplicate recipient fails");
+    Expect(!dex.Run({ BOB }, [&](Contract& contract) {
+        contract.TransferMany(BOB, { { ALICE, to_bob, "" }, { CAROL, to_bob, "" } });
+    }), "transfer.many above the balance fails");
+    Expect(dex.GetBalance(BOB, PAIR_TOKEN) == to_bob && dex.GetBalance(ALICE, PAIR_TOKEN).amount == 0,
+           "balances after the failed transfer.many");
+}
+
+}
+
+int main() {
+    host::Chain::Get().Reset();
+    host::Dex dex { SELF };
+    for (const name account : { ISSUER, FEE_COLLECTOR, ALICE, BOB, CAROL }) {
+        host::Chain::Get().AddAccount(account.value);
+    }
+
+    CheckCreatePair(dex);
+    if (failures == 0) {
+        CheckSwapIn(dex);
+        CheckRevert(dex);
+        CheckAuthorization(dex);
+        CheckTransferMany(dex);
+    }
+
+    if (failures > 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("host chain matches the contract\n");
+    return 0;
+}
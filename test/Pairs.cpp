@@ -0,0 +1,145 @@
+#include <Fixture.hpp>
+
+#include <cstdio>
+#include <string>
+#include <tuple>
+
+using namespace std;
+using namespace eosio;
+using namespace host::fixture;
+
+// Replaces the "stat" row of a pair with the v1 layout, which has "max_supply" after "supply" and no price
+// accumulators, on the host chain and checks that it is decoded as written, rewritten in the current layout by the
+// next swap and by migrate.pairs, and that migrate.pairs rejects invalid calls. Exits with 1 on a difference.
+namespace {
+
+const name ALICE = "alice"_n;
+
+// the row as written before v2
+vector<char> EncodeV1(const auto& record) {
+    return pack(make_tuple(record.supply, asset { MAX_SUPPLY, record.supply.symbol }, record.issuer, record.pool1,
+                           record.pool2, record.fee, record.fee_contract, int32_t(record.fee_contract_rate),
+                           int64_t(record.raw_pool1_amount), int64_t(record.raw_pool2_amount),
+                           int64_t(record.min_liquidity_amount)));
+}
+
+// bytes of the stat row of the pair
+vector<char> GetStatRow(const host::Dex& dex, const symbol_code pair_code) {
+    for (const host::SnapshotRow& row : dex.GetRows()) {
+        if (row.table == "stat"_n && row.scope == pair_code.raw()) {
+            return row.data;
+        }
+    }
+    return {};
+}
+
+void WriteStatRow(const host::Dex& dex, const symbol_code pair_code, const vector<char>& data) {
+    host::Chain& chain = host::Chain::Get();
+    const bool written = chain.Run(SELF.value, {}, [&] {
+        const int32_t row_it = chain.Find(SELF.value, pair_code.raw(), "stat"_n.value, pair_code.raw());
+        chain.Update(row_it, SELF.value, data.data(), uint32_t(data.size()));
+    });
+    Expect(written && GetStatRow(dex, pair_code) == data, "v1 row written");
+}
+
+// the fields of v1 are read, the price accumulators added later are zero
+void CheckDecoded(const host::Dex& dex, const auto& expected, const string& what) {
+    const auto record = dex.GetPair(PAIR_CODE);
+    Expect(record.has_value(), what + ": pair row");
+    if (!record) {
+        return;
+    }
+
+    Expect(record->supply == expected.supply && record->issuer == expected.issuer, what + ": supply and issuer");
+    Expect(record->pool1 == expected.pool1 && record->pool2 == expected.pool2, what + ": pools");
+    Expect(record->fee == expected.fee && record->fee_contract == expected.fee_contract
+           && record->fee_contract_rate == expected.fee_contract_rate, what + ": fee");
+    Expect(record->raw_pool1_amount == expected.raw_pool1_amount
+           && record->raw_pool2_amount == expected.raw_pool2_amount
+           && record->min_liquidity_amount == expected.min_liquidity_amount, what + ": raw pools and min liquidity");
+    Expect(record->price1_cumulative == 0 && record->price2_cumulative == 0 && record->last_update == 0,
+           what + ": price accumulators");
+}
+
+// a modify writes the struct layout
+void CheckSwapRewrites(host::Dex& dex) {
+    const auto before = *dex.GetPair(PAIR_CODE);
+    const vector<char> v1 = EncodeV1(before);
+    WriteStatRow(dex, PAIR_CODE, v1);
+    CheckDecoded(dex, before, "v1 row");
+
+    const int64_t in = CalculateAmountWithoutFee(100000, PAIR_FEE);
+    const int64_t out = CalculateOutAmount(in, before.pool1.quantity.amount, before.pool2.quantity.amount);
+    string error;
+    const bool swapped = dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 100000).quantity, "", &error)
+        && dex.Run({ ALICE }, [&](Contract& contract) {
+            contract.SwapIn(ALICE, PAIR_TOKEN, Token("TKA", 100000), Token("TKB", out), {});
+        }, &error);
+    Expect(swapped, "swap.in on the v1 row " + error);
+
+    const auto after = *dex.GetPair(PAIR_CODE);
+    Expect(after.pool1.quantity.amount == before.pool1.quantity.amount + in
+           && after.pool2.quantity.amount == before.pool2.quantity.amount - out, "pools after the swap on the v1 row");
+    const vector<char> row = GetStatRow(dex, PAIR_CODE);
+    Expect(row == pack(after) && row.size() == pack(before).size(), "row after the swap is in the current layout");
+}
+
+void CheckMigratePairs(host::Dex& dex) {
+    const auto before = *dex.GetPair(PAIR_CODE);
+    const vector<char> v1 = EncodeV1(before);
+    WriteStatRow(dex, PAIR_CODE, v1);
+
+    const vector<symbol_code> too_many(MAX_BATCH_SIZE + 1, PAIR_CODE);
+    const struct {
+        vector<name> auths;
+        vector<symbol_code> codes;
+        string what;
+    } failed[] = {
+        { { ALICE }, { PAIR_CODE }, "migrate.pairs authorized by alice" },
+        { { SELF }, {}, "migrate.pairs of no pairs" },
+        { { SELF }, too_many, "migrate.pairs of too many pairs" },
+        { { SELF }, { PAIR_CODE, symbol_code { "LPXY" } }, "migrate.pairs of an unknown pair" },
+    };
+    for (const auto& [auths, codes, what] : failed) {
+        Expect(!dex.Run(auths, [&](Contract& contract) {
+            contract.MigratePairs(codes);
+        }), what + " fails");
+    }
+    Expect(GetStatRow(dex, PAIR_CODE) == v1, "v1 row after the failed migrate.pairs");
+
+    string error;
+    const bool migrated = dex.Run({ SELF }, [&](Contract& contract) {
+        contract.MigratePairs({ PAIR_CODE });
+    }, &error);
+    Expect(migrated, "migrate.pairs " + error);
+    const vector<char> row = GetStatRow(dex, PAIR_CODE);
+    Expect(row == pack(*dex.GetPair(PAIR_CODE)) && row.size() == pack(before).size(),
+           "row after migrate.pairs is in the current layout");
+    CheckDecoded(dex, before, "migrated row");
+}
+
+}
+
+int main() {
+    host::Chain::Get().Reset();
+    host::Dex dex { SELF };
+    for (const name account : { ISSUER, FEE_COLLECTOR, ALICE }) {
+        host::Chain::Get().AddAccount(account.value);
+    }
+
+    string error;
+    const bool created = CreatePair(dex, Token("TKA", 1000000000), Token("TKB", 2000000000), PAIR_CODE, &error)
+        && AddLiquidity(dex, ISSUER, Token("TKA", 1000000000), Token("TKB", 2000000000), PAIR_TOKEN, &error);
+    Expect(created, "create.pair or addliquidity " + error);
+    if (failures == 0) {
+        CheckSwapRewrites(dex);
+        CheckMigratePairs(dex);
+    }
+
+    if (failures > 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("v1 pair rows are read and migrated\n");
+    return 0;
+}
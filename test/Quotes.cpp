@@ -0,0 +1,439 @@
+#include <Fixture.hpp>
+
+#include <cstdio>
+#include <limits>
+#include <string>
+
+using namespace std;
+using namespace eosio;
+using namespace host::fixture;
+
+// Runs quote.swap, quote.add, quote.remove, quote.twap, quote.volume and quote.route on the host chain, checks that
+// they leave every table unchanged, that the actions run right after them pay and receive the quoted amounts, that
+// the TWAP of a swap in the middle of the window weights both prices by their time, that the volumes are summed per
+// hourly bucket, reset when a bucket is reused and saturate, and that a route through a pair whose out amount
+// overflows is dropped instead of failing the quote. Exits with 1 on a difference.
+namespace {
+
+const name ALICE = "alice"_n;
+
+const uint32_t START_TIME = 1714564800;    // 2024-05-01T12:00:00, the start of an observation period
+
+void SetTime(const uint32_t seconds) {
+    host::Chain::Get().SetTime(uint64_t(seconds) * 1000000);
+}
+
+// new chain with the pair created and the liquidity of the issuer added at START_TIME
+host::Dex Start() {
+    host::Chain::Get().Reset();
+    SetTime(START_TIME);
+    host::Dex dex { SELF };
+    for (const name account : { ISSUER, FEE_COLLECTOR, ALICE }) {
+        host::Chain::Get().AddAccount(account.value);
+    }
+
+    string error;
+    const bool created = CreatePair(dex, Token("TKA", 1000000000), Token("TKB", 2000000000), PAIR_CODE, &error)
+        && AddLiquidity(dex, ISSUER, Token("TKA", 1000000000), Token("TKB", 2000000000), PAIR_TOKEN, &error);
+    Expect(created, "create.pair or addliquidity " + error);
+    return dex;
+}
+
+bool SameRows(const vector<host::SnapshotRow>& rows1, const vector<host::SnapshotRow>& rows2) {
+    if (rows1.size() != rows2.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < rows1.size(); i++) {
+        if (rows1[i].table != rows2[i].table || rows1[i].scope != rows2[i].scope || rows1[i].payer != rows2[i].payer
+            || rows1[i].data != rows2[i].data) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// runs the quote and checks that no row was changed
+template<typename Quote>
+bool RunQuote(host::Dex& dex, Quote&& quote, const string& what) {
+    const vector<host::SnapshotRow> before = dex.GetRows();
+    string error;
+    const bool quoted = dex.Run({}, quote, &error);
+    Expect(quoted, what + " " + error);
+    Expect(SameRows(dex.GetRows(), before), "tables after " + what);
+    return quoted;
+}
+
+bool SameHop(const Contract::SwapHop& hop1, const Contract::SwapHop& hop2) {
+    return hop1.in == hop2.in && hop1.fee == hop2.fee && hop1.fee_collector_share == hop2.fee_collector_share
+        && hop1.out == hop2.out;
+}
+
+void CheckQuoteSwap(host::Dex& dex) {
+    const Contract::SwapLeg exact_in { PAIR_TOKEN, Token("TKA", 100000), Token("TKB", 0), true };
+    vector<Contract::SwapQuote> quotes;
+    if (!RunQuote(dex, [&](Contract& contract) {
+        quotes = contract.QuoteSwap({ exact_in, exact_in });
+    }, "quote.swap of exact in")) {
+        return;
+    }
+
+    // the requests are independent, the second one is not quoted after the first
+    const auto pair = *dex.GetPair(PAIR_CODE);
+    Expect(quotes.size() == 2 && SameHop(quotes[0].hop, quotes[1].hop), "quotes of the same request");
+    Expect(quotes[0].max_out.quantity.amount > 0 && quotes[0].max_out.quantity < pair.pool2.quantity,
+           "max out of the quote");
+
+    Contract::SwapResult result;
+    string error;
+    const bool swapped = dex.Deposit(TOKEN_CONTRACT, ALICE, exact_in.in.quantity, "", &error)
+        && dex.Run({ ALICE }, [&](Contract& contract) {
+            result = contract.SwapIn(ALICE, PAIR_TOKEN, exact_in.in, exact_in.out, {});
+        }, &error);
+    Expect(swapped, "swap.in " + error);
+    Expect(SameHop(result.hop, quotes[0].hop), "swap.in as quoted");
+
+    const Contract::SwapLeg exact_out { PAIR_TOKEN, Token("TKB", 100000), Token("TKA", 40000), false };
+    if (!RunQuote(dex, [&](Contract& contract) {
+        quotes = contract.QuoteSwap({ exact_out });
+    }, "quote.swap of exact out")) {
+        return;
+    }
+
+    const bool swapped_out = dex.Deposit(TOKEN_CONTRACT, ALICE, exact_out.in.quantity, "", &error)
+        && dex.Run({ ALICE }, [&](Contract& contract) {
+            result = contract.Swap(ALICE, PAIR_TOKEN, exact_out.in, exact_out.out, {});
+        }, &error);
+    Expect(swapped_out, "swap " + error);
+    Expect(quotes.size() == 1 && SameHop(result.hop, quotes[0].hop), "swap as quoted");
+    Expect(result.refund == exact_out.in - result.hop.in - result.hop.fee, "refund of the swap");
+
+    Expect(!dex.Run({}, [&](Contract& contract) {
+        contract.QuoteSwap({ exact_in, { symbol { "LPXY", 4 }, exact_in.in, exact_in.out, true } });
+    }), "quote.swap of an unknown pair fails");
+}
+
+void CheckQuoteAddLiquidity(host::Dex& dex) {
+    const Contract::AddLiquidityRequest request { PAIR_TOKEN, Token("TKA", 10000000), Token("TKB", 30000000) };
+    vector<Contract::LiquidityQuote> quotes;
+    if (!RunQuote(dex, [&](Contract& contract) {
+        quotes = contract.QuoteAddLiquidity({ request });
+    }, "quote.add")) {
+        return;
+    }
+
+    // the add liquidity fee of 10^-6 is at least a unit, the deposits cover it on top of the maximal amounts
+    Contract::LiquidityResult result;
+    string error;
+    const bool added = dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 10010000).quantity, "", &error)
+        && dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKB", 30030000).quantity, "", &error)
+        && dex.Run({ ALICE }, [&](Contract& contract) {
+            result = contract.AddLiquidity(ALICE, PAIR_TOKEN, request.max_asset1, request.max_asset2, {});
+        }, &error);
+    Expect(added, "addliquidity " + error);
+    Expect(quotes.size() == 1 && quotes[0].liquidity == result.liquidity && quotes[0].asset1 == result.asset1
+           && quotes[0].asset2 == result.asset2 && quotes[0].fee1 == result.fee1 && quotes[0].fee2 == result.fee2,
+           "addliquidity as quoted");
+    Expect(result.liquidity.amount > 0 && dex.GetBalance(ALICE, PAIR_TOKEN) == result.liquidity,
+           "liquidity of alice");
+
+    Expect(!dex.Run({}, [&](Contract& contract) {
+        contract.QuoteAddLiquidity({ { symbol { "LPXY", 4 }, request.max_asset1, request.max_asset2 } });
+    }), "quote.add of an unknown pair fails");
+}
+
+void CheckQuoteRemoveLiquidity(host::Dex& dex) {
+    const asset to_sell { dex.GetBalance(ALICE, PAIR_TOKEN).amount / 2, PAIR_TOKEN };
+    vector<Contract::LiquidityQuote> quotes;
+    if (!RunQuote(dex, [&](Contract& contract) {
+        quotes = contract.QuoteRemoveLiquidity({ to_sell });
+    }, "quote.remove")) {
+        return;
+    }
+
+    Contract::LiquidityResult result;
+    string error;
+    const bool removed = dex.Run({ ALICE }, [&](Contract& contract) {
+        result = contract.RemoveLiquidity(ALICE, to_sell, Token("TKA", 1), Token("TKB", 1), {});
+    }, &error);
+    Expect(removed, "remliquidity " + error);
+    Expect(quotes.size() == 1 && quotes[0].liquidity == to_sell && quotes[0].asset1 == result.asset1
+           && quotes[0].asset2 == result.asset2 && quotes[0].fee1 == result.fee1 && quotes[0].fee2 == result.fee2,
+           "remliquidity as quoted");
+
+    // more than the supply
+    Expect(!dex.Run({}, [&](Contract& contract) {
+        contract.QuoteRemoveLiquidity({ { dex.GetPair(PAIR_CODE)->supply.amount + 1, PAIR_TOKEN } });
+    }), "quote.remove above the supply fails");
+}
+
+// the pools hold the price p0 from START_TIME, a swap at START_TIME + 600 changes it to p1 and the TWAP is quoted at
+// START_TIME + 1200
+void CheckQuoteTwap() {
+    host::Dex dex = Start();
+    const auto created = *dex.GetPair(PAIR_CODE);
+    const uint128_t p0_1 = DivideToQ64(created.pool2.quantity.amount, created.pool1.quantity.amount);
+    const uint128_t p0_2 = DivideToQ64(created.pool1.quantity.amount, created.pool2.quantity.amount);
+
+    SetTime(START_TIME + 600);
+    string error;
+    const bool swapped = dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 100000000).quantity, "", &error)
+        && dex.Run({ ALICE }, [&](Contract& contract) {
+            contract.SwapIn(ALICE, PAIR_TOKEN, Token("TKA", 100000000), Token("TKB", 0), {});
+        }, &error);
+    Expect(swapped, "swap.in " + error);
+    const auto swapped_pair = *dex.GetPair(PAIR_CODE);
+    const uint128_t p1_1 = DivideToQ64(swapped_pair.pool2.quantity.amount, swapped_pair.pool1.quantity.amount);
+    const uint128_t p1_2 = DivideToQ64(swapped_pair.pool1.quantity.amount, swapped_pair.pool2.quantity.amount);
+    Expect(p1_1 < p0_1, "price after the swap");
+
+    SetTime(START_TIME + 1200);
+    const struct {
+        uint32_t window;
+        uint32_t start;
+        uint128_t price1;
+        uint128_t price2;
+    } expected[] = {
+        { 0, START_TIME + 1200, p1_1, p1_2 },
+        { 600, START_TIME + 600, p1_1, p1_2 },
+        // no observation in the period of START_TIME + 300, the earlier one is used
+        { 900, START_TIME, DivideBy64(p0_1 * 600 + p1_1 * 600, 1200), DivideBy64(p0_2 * 600 + p1_2 * 600, 1200) },
+        { 1200, START_TIME, DivideBy64(p0_1 * 600 + p1_1 * 600, 1200), DivideBy64(p0_2 * 600 + p1_2 * 600, 1200) },
+    };
+    for (const auto& [window, start, price1, price2] : expected) {
+        Contract::PriceTwap twap;
+        if (!RunQuote(dex, [&](Contract& contract) {
+            twap = contract.QuoteTwap(PAIR_CODE, window);
+        }, "quote.twap of " + to_string(window) + " seconds")) {
+            continue;
+        }
+
+        Expect(twap.start.time.sec_since_epoch() == start && twap.end.time.sec_since_epoch() == START_TIME + 1200,
+               "period of the window of " + to_string(window) + " seconds");
+        Expect(twap.price1 == price1 && twap.price2 == price2, "TWAP of " + to_string(window) + " seconds");
+    }
+
+    const struct {
+        symbol_code pair_code;
+        uint32_t window;
+        string message;
+    } failed[] = {
+        { PAIR_CODE, (TWAP_OBSERVATIONS - 1) * TWAP_OBSERVATION_PERIOD + 1, "window is longer than the observations" },
+        { PAIR_CODE, 1500, "no observation for the window" },
+        { symbol_code { "LPXY" }, 600, "pair token does not exist" },
+    };
+    for (const auto& [pair_code, window, message] : failed) {
+        const bool quoted = dex.Run({}, [&](Contract& contract) {
+            contract.QuoteTwap(pair_code, window);
+        }, &error);
+        Expect(!quoted && error.find(message) != string::npos,
+               "quote.twap of " + to_string(window) + " seconds of " + pair_code.to_string() + " fails: " + error);
+    }
+}
+
+bool SameStats(const Contract::VolumeStats& stats1, const Contract::VolumeStats& stats2) {
+    return stats1.volume1_in == stats2.volume1_in && stats1.volume1_out == stats2.volume1_out
+        && stats1.volume2_in == stats2.volume2_in && stats1.volume2_out == stats2.volume2_out
+        && stats1.fee1 == stats2.fee1 && stats1.fee2 == stats2.fee2 && stats1.trades == stats2.trades
+        && stats1.liquidity_changes == stats2.liquidity_changes;
+}
+
+// swap.in of "in" at "time", the volume of the swap is added to "stats"
+void SwapAt(host::Dex& dex, const uint32_t time, const extended_asset& in, const extended_symbol& out_token,
+            Contract::VolumeStats& stats) {
+    SetTime(time);
+    Contract::SwapResult result;
+    string error;
+    const bool swapped = dex.Deposit(in.contract, ALICE, in.quantity, "", &error)
+        && dex.Run({ ALICE }, [&](Contract& contract) {
+            result = contract.SwapIn(ALICE, PAIR_TOKEN, in, { 0, out_token }, {});
+        }, &error);
+    Expect(swapped, "swap.in of " + in.quantity.to_string() + " " + error);
+
+    const bool first = in.get_extended_symbol() == Token("TKA", 0).get_extended_symbol();
+    (first ? stats.volume1_in : stats.volume2_in) += result.hop.in.quantity.amount;
+    (first ? stats.fee1 : stats.fee2) += result.hop.fee.quantity.amount;
+    (first ? stats.volume2_out : stats.volume1_out) += result.hop.out.quantity.amount;
+    stats.trades++;
+}
+
+Contract::VolumeStats QuoteVolume(host::Dex& dex, const uint32_t window) {
+    Contract::VolumeQuote quote;
+    RunQuote(dex, [&](Contract& contract) {
+        quote = contract.QuoteVolume(PAIR_CODE, window);
+    }, "quote.volume of " + to_string(window) + " seconds");
+    return quote.stats;
+}
+
+// the pair is created at the start of an hour, swaps follow in that hour, in the next one and in the hour which
+// reuses the bucket of the first one
+void CheckQuoteVolume() {
+    host::Dex dex = Start();
+    const extended_symbol tka = Token("TKA", 0).get_extended_symbol();
+    const extended_symbol tkb = Token("TKB", 0).get_extended_symbol();
+
+    // the add liquidity fees of the issuer
+    Contract::VolumeStats first_hour = QuoteVolume(dex, 0);
+    Expect(first_hour.liquidity_changes == 1 && first_hour.fee1 > 0 && first_hour.trades == 0,
+           "volume of addliquidity");
+
+    Contract::VolumeStats second_hour;
+    SwapAt(dex, START_TIME + 60, Token("TKA", 100000), tkb, first_hour);
+    SwapAt(dex, START_TIME + 120, Token("TKB", 300000), tka, first_hour);
+    SwapAt(dex, START_TIME + VOLUME_BUCKET_PERIOD + 60, Token("TKB", 200000), tka, second_hour);
+
+    SetTime(START_TIME + VOLUME_BUCKET_PERIOD + 120);
+    Contract::VolumeStats both_hours = first_hour;
+    both_hours.volume1_in += second_hour.volume1_in;
+    both_hours.volume1_out += second_hour.volume1_out;
+    both_hours.volume2_in += second_hour.volume2_in;
+    both_hours.volume2_out += second_hour.volume2_out;
+    both_hours.fee1 += second_hour.fee1;
+    both_hours.fee2 += second_hour.fee2;
+    both_hours.trades += second_hour.trades;
+    Expect(SameStats(QuoteVolume(dex, 0), second_hour), "volume of the current hour");
+    Expect(SameStats(QuoteVolume(dex, 120), second_hour), "volume of the window within the current hour");
+    Expect(SameStats(QuoteVolume(dex, VOLUME_BUCKET_PERIOD + 120), both_hours), "volume of both hours");
+
+    // the bucket of the first hour is reused, the old sums are dropped
+    const uint32_t reused = START_TIME + VOLUME_BUCKETS * VOLUME_BUCKET_PERIOD;
+    SetTime(reused + 60);
+    Expect(SameStats(QuoteVolume(dex, 60), {}), "no volume of the hour before the swap");
+    Contract::VolumeStats reused_hour;
+    SwapAt(dex, reused + 60, Token("TKA", 100000), tkb, reused_hour);
+    Expect(SameStats(QuoteVolume(dex, 60), reused_hour), "volume of the reused bucket");
+
+    string error;
+    const bool quoted = dex.Run({}, [&](Contract& contract) {
+        contract.QuoteVolume(PAIR_CODE, VOLUME_BUCKETS * VOLUME_BUCKET_PERIOD);
+    }, &error);
+    Expect(!quoted && error.find("window is longer than the buckets") != string::npos,
+           "quote.volume of all buckets fails: " + error);
+}
+
+// buckets close to the maximum are loaded, the swap and the quote over both saturate
+void CheckVolumeSaturation() {
+    host::Dex dex = Start();
+    const uint32_t time = START_TIME + 10 * VOLUME_BUCKET_PERIOD;
+    const uint32_t period = time / VOLUME_BUCKET_PERIOD;
+    const uint64_t max_volume = numeric_limits<uint64_t>::max();
+    const uint32_t max_count = numeric_limits<uint32_t>::max();
+
+    // slot, period and the fields of VolumeStats
+    vector<host::SnapshotRow> rows;
+    for (const uint32_t bucket_period : { period - 1, period }) {
+        rows.push_back({ "volumes"_n, PAIR_CODE.raw(), SELF, pack(make_tuple(
+            uint64_t(bucket_period % VOLUME_BUCKETS), bucket_period, max_volume - 10, uint64_t(0), uint64_t(0),
+            max_volume - 10, max_volume - 10, uint64_t(0), max_count - 1, uint32_t(0))) });
+    }
+    string error;
+    const bool loaded = dex.LoadRows(rows, &error);
+    Expect(loaded, "volume rows " + error);
+
+    Contract::VolumeStats stats;
+    SwapAt(dex, time, Token("TKA", 100000), Token("TKB", 0).get_extended_symbol(), stats);
+
+    const Contract::VolumeStats quoted = QuoteVolume(dex, VOLUME_BUCKET_PERIOD);
+    Expect(quoted.volume1_in == max_volume && quoted.volume2_out == max_volume && quoted.fee1 == max_volume
+           && quoted.trades == max_count, "saturated sums");
+    Expect(quoted.volume1_out == 0 && quoted.volume2_in == 0 && quoted.liquidity_changes == 0, "sums of zero");
+
+    const Contract::VolumeStats current = QuoteVolume(dex, 0);
+    Expect(current.volume1_in == max_volume && current.trades == max_count, "saturated bucket");
+}
+
+// TKA reaches TKC through TKB; the pairs of one unit of TKA or TKB against almost INIT_MAX of another token would pay
+// out more than asset::max_amount on the first or the second hop
+void CheckQuoteRoute() {
+    host::Dex dex = Start();
+    const struct {
+        const char* code;
+        extended_asset pool1;
+        extended_asset pool2;
+        bool added;
+    } pairs[] = {
+        { "LPBC", Token("TKB", 2000000000), Token("TKC", 4000000000), true },
+        { "LPAX", Token("TKA", 1), Token("TKX", INIT_MAX - 1), false },
+        { "LPXC", Token("TKX", 1000000000), Token("TKC", 1000000000), true },
+        { "LPBY", Token("TKB", 1), Token("TKY", INIT_MAX - 1), false },
+        { "LPYC", Token("TKY", 1000000000), Token("TKC", 1000000000), true },
+    };
+    for (const auto& [code, pool1, pool2, added] : pairs) {
+        string error;
+        const symbol token { symbol_code { code }, 4 };
+        const bool created = CreatePair(dex, pool1, pool2, token.code(), &error)
+            && (!added || AddLiquidity(dex, ISSUER, pool1, pool2, token, &error));
+        Expect(created, string("create.pair of ") + code + " " + error);
+    }
+
+    const extended_asset in = Token("TKA", 1000000);
+    const extended_symbol out_token = Token("TKC", 0).get_extended_symbol();
+    const auto first = *dex.GetPair(PAIR_CODE);
+    const auto second = *dex.GetPair(symbol_code { "LPBC" });
+    const int64_t out1 = CalculateOutAmount(CalculateAmountWithoutFee(in.quantity.amount, PAIR_FEE),
+                                            first.pool1.quantity.amount, first.pool2.quantity.amount);
+    const int64_t out2 = CalculateOutAmount(CalculateAmountWithoutFee(out1, PAIR_FEE),
+                                            second.pool1.quantity.amount, second.pool2.quantity.amount);
+
+    vector<Contract::RouteQuote> routes;
+    if (RunQuote(dex, [&](Contract& contract) {
+        routes = contract.QuoteRoute(in, out_token, MAX_PATH_LENGTH);
+    }, "quote.route")) {
+        Expect(routes.size() == 1, "one route without the overflowing pairs");
+        Expect(!routes.empty() && routes[0].path == vector<symbol> { PAIR_TOKEN, symbol { "LPBC", 4 } }
+               && routes[0].out == extended_asset { out2, out_token }, "route through TKB");
+    }
+
+    string error;
+    const bool swapped = !routes.empty() && dex.Deposit(in.contract, ALICE, in.quantity, "", &error)
+        && dex.Run({ ALICE }, [&](Contract& contract) {
+            contract.SwapPath(ALICE, routes[0].path, in, routes[0].out, true);
+        }, &error);
+    Expect(swapped, "swap.path of the route " + error);
+
+    // no direct pair
+    if (RunQuote(dex, [&](Contract& contract) {
+        routes = contract.QuoteRoute(in, out_token, 1);
+    }, "quote.route of one hop")) {
+        Expect(routes.empty(), "no route of one hop");
+    }
+
+    const struct {
+        extended_asset in;
+        extended_symbol out_token;
+        uint8_t max_hops;
+        string message;
+    } failed[] = {
+        { Token("TKA", 0), out_token, 2, "in must be positive" },
+        { in, in.get_extended_symbol(), 2, "extended symbols must be different" },
+        { in, out_token, 0, "invalid max_hops" },
+        { in, out_token, MAX_PATH_LENGTH + 1, "invalid max_hops" },
+    };
+    for (const auto& [failed_in, failed_out_token, max_hops, message] : failed) {
+        const bool quoted = dex.Run({}, [&](Contract& contract) {
+            contract.QuoteRoute(failed_in, failed_out_token, max_hops);
+        }, &error);
+        Expect(!quoted && error.find(message) != string::npos, "quote.route fails with " + message + ": " + error);
+    }
+}
+
+}
+
+int main() {
+    host::Dex dex = Start();
+    if (failures == 0) {
+        CheckQuoteSwap(dex);
+        CheckQuoteAddLiquidity(dex);
+        CheckQuoteRemoveLiquidity(dex);
+    }
+    CheckQuoteTwap();
+    CheckQuoteVolume();
+    CheckVolumeSaturation();
+    CheckQuoteRoute();
+
+    if (failures > 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("quotes match the actions\n");
+    return 0;
+}
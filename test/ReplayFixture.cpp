@@ -0,0 +1,162 @@
+#include <Fixture.hpp>
+#include "../bench/Snapshot.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+
+using namespace std;
+using namespace eosio;
+using namespace host::fixture;
+
+// Writes the fixture of the replay test to <directory>: start.jsonl with a pair created on the host chain,
+// actions.jsonl with deposits, swaps, liquidity changes, an LP transfer and a withdrawal in the format of the action
+// traces, and end.jsonl with the tables after running the same actions directly. dex-replay of the log from
+// start.jsonl has to end with the reserves of end.jsonl.
+namespace {
+
+const name ALICE = "alice"_n;
+const name BOB = "bob"_n;
+const name CAROL = "carol"_n;
+
+const uint64_t START_TIME = 1714564800;    // 2024-05-01T12:00:00
+
+string Quote(const string& value) {
+    return "\"" + value + "\"";
+}
+
+string ToJson(const extended_asset& value) {
+    return R"({"quantity":)" + Quote(value.quantity.to_string()) + R"(,"contract":)"
+        + Quote(value.contract.to_string()) + "}";
+}
+
+string ToJson(const symbol& value) {
+    return Quote(to_string(value.precision()) + "," + value.code().to_string());
+}
+
+class Fixture {
+public:
+    explicit Fixture(const string& directory) : directory(directory), log(directory + "/actions.jsonl") {}
+
+    // the liquidity of the issuer is added before the snapshot, nothing can be swapped out of a new pair
+    bool CreatePair() {
+        return host::fixture::CreatePair(dex, Token("TKA", 1000000000), Token("TKB", 3000000000))
+            && AddLiquidity(dex, ISSUER, Token("TKA", 1000000000), Token("TKB", 3000000000))
+            && bench::WriteSnapshot(directory + "/start.jsonl", dex.GetRows());
+    }
+
+    // token transfer to the contract
+    void Deposit(const name from, const extended_asset& quantity, const string& memo = "") {
+        Log(quantity.contract, "transfer", R"({"from":)" + Quote(from.to_string()) + R"(,"to":)"
+            + Quote(SELF.to_string()) + R"(,"quantity":)" + Quote(quantity.quantity.to_string()) + R"(,"memo":)"
+            + Quote(memo) + "}", [&] {
+            return dex.Deposit(quantity.contract, from, quantity.quantity, memo);
+        });
+    }
+
+    void Action(const name user, const string& action_name, const string& data,
+                const function<void(Contract&)>& action) {
+        Log(SELF, action_name, data, [&] {
+            return dex.Run({ user }, action);
+        });
+    }
+
+    [[nodiscard]] asset GetBalance(const name user) const { return dex.GetBalance(user, PAIR_TOKEN); }
+
+    bool Finish() {
+        log.close();
+        return failures == 0 && bool(log) && bench::WriteSnapshot(directory + "/end.jsonl", dex.GetRows());
+    }
+
+private:
+    // every action runs a minute after the previous one
+    void Log(const name account, const string& action_name, const string& data, const function<bool()>& run) {
+        time += 60;
+        host::Chain::Get().SetTime(time * 1000000);
+        log << R"({"account":)" << Quote(account.to_string()) << R"(,"name":)" << Quote(action_name)
+            << R"(,"time":)" << time << R"(,"data":)" << data << "}\n";
+        if (!run()) {
+            printf("failed: %s\n", action_name.c_str());
+            failures++;
+        }
+    }
+
+    string directory;
+    ofstream log;
+    host::Dex dex { SELF };
+    uint64_t time = START_TIME;
+    uint32_t failures = 0;
+};
+
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: dex-replay-fixture <directory>\n");
+        return 2;
+    }
+
+    host::Chain::Get().Reset();
+    for (const name account : { ISSUER, FEE_COLLECTOR, ALICE, BOB, CAROL }) {
+        host::Chain::Get().AddAccount(account.value);
+    }
+
+    Fixture fixture { argv[1] };
+    if (!fixture.CreatePair()) {
+        printf("cannot create the pair\n");
+        return 1;
+    }
+
+    fixture.Deposit(ALICE, Token("TKA", 1000000));
+    fixture.Action(ALICE, "swap.in", R"({"user":"alice","pair_token":)" + ToJson(PAIR_TOKEN) + R"(,"in":)"
+                   + ToJson(Token("TKA", 1000000)) + R"(,"min_out":)" + ToJson(Token("TKB", 0)) + "}",
+                   [](Contract& contract) {
+        contract.SwapIn(ALICE, PAIR_TOKEN, Token("TKA", 1000000), Token("TKB", 0), {});
+    });
+
+    fixture.Deposit(BOB, Token("TKB", 2500000), "swap:LPAB:0");
+
+    fixture.Deposit(BOB, Token("TKB", 1000000));
+    fixture.Action(BOB, "swap", R"({"user":"bob","pair_token":)" + ToJson(PAIR_TOKEN) + R"(,"max_in":)"
+                   + ToJson(Token("TKB", 1000000)) + R"(,"expected_out":)" + ToJson(Token("TKA", 300000))
+                   + R"(,"keep_on_deposit":true})", [](Contract& contract) {
+        binary_extension<bool> keep_on_deposit;
+        keep_on_deposit.emplace(true);
+        contract.Swap(BOB, PAIR_TOKEN, Token("TKB", 1000000), Token("TKA", 300000), keep_on_deposit);
+    });
+
+    // the add liquidity fee is paid on top of the added amounts
+    fixture.Deposit(CAROL, Token("TKA", 5000100));
+    fixture.Deposit(CAROL, Token("TKB", 16000100));
+    fixture.Action(CAROL, "addliquidity", R"({"user":"carol","token":)" + ToJson(PAIR_TOKEN) + R"(,"max_asset1":)"
+                   + ToJson(Token("TKA", 5000000)) + R"(,"max_asset2":)" + ToJson(Token("TKB", 16000000)) + "}",
+                   [](Contract& contract) {
+        contract.AddLiquidity(CAROL, PAIR_TOKEN, Token("TKA", 5000000), Token("TKB", 16000000), {});
+    });
+
+    const asset liquidity = fixture.GetBalance(CAROL);
+    const asset to_transfer { liquidity.amount / 4, PAIR_TOKEN };
+    fixture.Action(CAROL, "transfer", R"({"from":"carol","to":"alice","quantity":)"
+                   + Quote(to_transfer.to_string()) + R"(,"memo":"lp"})", [&](Contract& contract) {
+        contract.Transfer(CAROL, ALICE, to_transfer, "lp");
+    });
+
+    const asset to_sell { liquidity.amount / 2, PAIR_TOKEN };
+    fixture.Action(CAROL, "remliquidity", R"({"user":"carol","to_sell":)" + Quote(to_sell.to_string())
+                   + R"(,"min_asset1":)" + ToJson(Token("TKA", 1)) + R"(,"min_asset2":)" + ToJson(Token("TKB", 1))
+                   + "}", [&](Contract& contract) {
+        contract.RemoveLiquidity(CAROL, to_sell, Token("TKA", 1), Token("TKB", 1), {});
+    });
+
+    fixture.Action(BOB, "withdraw", R"({"user":"bob","token":{"sym":"4,TKA","contract":"eosio.token"}})",
+                   [](Contract& contract) {
+        contract.Withdraw(BOB, Token("TKA", 0).get_extended_symbol());
+    });
+
+    if (!fixture.Finish()) {
+        return 1;
+    }
+    printf("fixture written to %s\n", argv[1]);
+    return 0;
+}
@@ -0,0 +1,356 @@
+#include <Fixture.hpp>
+#include <Util.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+using namespace eosio;
+using namespace host::fixture;
+
+// Runs swap.path over two pairs, swap.batch, swaps by transfer memo, claim.fees and swaps and liquidity changes with
+// keep_on_deposit on the host chain and checks the paid out amounts, the settled deposits and the accrued and claimed
+// fees against the pricing of the contract, and that a path using a pair twice and invalid memos fail without
+// changing the pools and the deposits. Exits with 1 on a difference.
+namespace {
+
+const name ALICE = "alice"_n;
+const name BOB = "bob"_n;
+
+const symbol_code SECOND_PAIR_CODE { "LPBC" };
+const symbol SECOND_PAIR_TOKEN { SECOND_PAIR_CODE, 4 };
+
+// new chain with the pairs TKA/TKB and TKB/TKC, both with the liquidity of the issuer added
+host::Dex Start() {
+    host::Chain::Get().Reset();
+    host::Dex dex { SELF };
+    for (const name account : { ISSUER, FEE_COLLECTOR, ALICE, BOB }) {
+        host::Chain::Get().AddAccount(account.value);
+    }
+
+    string error;
+    const bool created = CreatePair(dex, Token("TKA", 1000000000), Token("TKB", 2000000000), PAIR_CODE, &error)
+        && AddLiquidity(dex, ISSUER, Token("TKA", 1000000000), Token("TKB", 2000000000), PAIR_TOKEN, &error)
+        && CreatePair(dex, Token("TKB", 2000000000), Token("TKC", 4000000000), SECOND_PAIR_CODE, &error)
+        && AddLiquidity(dex, ISSUER, Token("TKB", 2000000000), Token("TKC", 4000000000), SECOND_PAIR_TOKEN, &error);
+    Expect(created, "create.pair or addliquidity " + error);
+    return dex;
+}
+
+// every hop sells the whole out of the previous one
+void CheckSwapPath() {
+    host::Dex dex = Start();
+    const auto first = *dex.GetPair(PAIR_CODE);
+    const auto second = *dex.GetPair(SECOND_PAIR_CODE);
+
+    const int64_t in1 = CalculateAmountWithoutFee(100000, PAIR_FEE);
+    const int64_t out1 = CalculateOutAmount(in1, first.pool1.quantity.amount, first.pool2.quantity.amount);
+    const int64_t in2 = CalculateAmountWithoutFee(out1, PAIR_FEE);
+    const int64_t out2 = CalculateOutAmount(in2, second.pool1.quantity.amount, second.pool2.quantity.amount);
+
+    Expect(dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 100000).quantity), "deposit of alice");
+    string error;
+    const bool swapped = dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.SwapPath(ALICE, { PAIR_TOKEN, SECOND_PAIR_TOKEN }, Token("TKA", 100000), Token("TKC", out2), true);
+    }, &error);
+    Expect(swapped, "swap.path " + error);
+
+    const vector<host::Transfer> transfers = dex.GetTransfers();
+    Expect(transfers.size() == 1 && transfers[0].to == ALICE && transfers[0].quantity == Token("TKC", out2).quantity,
+           "out of swap.path");
+
+    const auto first_after = *dex.GetPair(PAIR_CODE);
+    const auto second_after = *dex.GetPair(SECOND_PAIR_CODE);
+    Expect(first_after.pool1.quantity.amount == first.pool1.quantity.amount + in1
+           && first_after.pool2.quantity.amount == first.pool2.quantity.amount - out1, "pools of the first hop");
+    Expect(second_after.pool1.quantity.amount == second.pool1.quantity.amount + in2
+           && second_after.pool2.quantity.amount == second.pool2.quantity.amount - out2, "pools of the second hop");
+    Expect(dex.GetDeposit(ALICE, Token("TKA", 0).get_extended_symbol()).quantity.amount == 0, "deposit is sold");
+}
+
+// pairs are compared by code, the precision of the path entry does not matter
+void CheckDuplicatePair() {
+    host::Dex dex = Start();
+    Expect(dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 100000).quantity), "deposit of alice");
+    const auto before = *dex.GetPair(PAIR_CODE);
+
+    const vector<symbol> paths[] = {
+        { PAIR_TOKEN, PAIR_TOKEN },
+        { symbol { PAIR_CODE, 4 }, symbol { PAIR_CODE, 8 } },
+    };
+    for (const vector<symbol>& path : paths) {
+        string error;
+        const bool swapped = dex.Run({ ALICE }, [&](Contract& contract) {
+            contract.SwapPath(ALICE, path, Token("TKA", 100000), Token("TKA", 0), true);
+        }, &error);
+        Expect(!swapped && error.find("pair is used twice in the path") != string::npos,
+               "swap.path through " + path[0].to_string() + " and " + path[1].to_string() + " fails: " + error);
+    }
+
+    const auto after = *dex.GetPair(PAIR_CODE);
+    Expect(after.pool1 == before.pool1 && after.pool2 == before.pool2, "pools after the failed swap.path");
+    Expect(dex.GetDeposit(ALICE, Token("TKA", 0).get_extended_symbol()).quantity.amount == 100000,
+           "deposit after the failed swap.path");
+    Expect(dex.GetTransfers().empty(), "no transfers of the failed swap.path");
+}
+
+// the legs run in order against the pools left by the previous ones; TKB received by the first leg pays for the
+// second, so only the net amounts are settled: TKA is taken from the deposit, TKB and TKC are sent with one transfer
+// each and the fees of both TKA legs are accrued together
+void CheckSwapBatch() {
+    host::Dex dex = Start();
+    const auto first = *dex.GetPair(PAIR_CODE);
+    const auto second = *dex.GetPair(SECOND_PAIR_CODE);
+    const extended_symbol tka = Token("TKA", 0).get_extended_symbol();
+    const extended_symbol tkb = Token("TKB", 0).get_extended_symbol();
+    const int64_t fee_tka = dex.GetFee(FEE_COLLECTOR, tka).quantity.amount;
+    const int64_t fee_tkb = dex.GetFee(FEE_COLLECTOR, tkb).quantity.amount;
+
+    // exact in of 100000 TKA
+    const int64_t in1 = CalculateAmountWithoutFee(100000, PAIR_FEE);
+    const int64_t out1 = CalculateOutAmount(in1, first.pool1.quantity.amount, first.pool2.quantity.amount);
+    // exact in of 50000 TKB
+    const int64_t in2 = CalculateAmountWithoutFee(50000, PAIR_FEE);
+    const int64_t out2 = CalculateOutAmount(in2, second.pool1.quantity.amount, second.pool2.quantity.amount);
+    // exact out of 10000 TKB against the pools after the first leg
+    const int64_t in3 = CalculateInAmount(10000, first.pool1.quantity.amount + in1, first.pool2.quantity.amount - out1);
+    const int64_t fee3 = GetRateOf(in3, PAIR_FEE);
+
+    Expect(dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 300000).quantity), "deposit of alice");
+    string error;
+    const bool swapped = dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.SwapBatch(ALICE, {
+            { PAIR_TOKEN, Token("TKA", 100000), Token("TKB", 0), true },
+            { SECOND_PAIR_TOKEN, Token("TKB", 50000), Token("TKC", 0), true },
+            { PAIR_TOKEN, Token("TKA", 100000), Token("TKB", 10000), false },
+        });
+    }, &error);
+    Expect(swapped, "swap.batch " + error);
+
+    const vector<host::Transfer> transfers = dex.GetTransfers();
+    Expect(transfers.size() == 2, "one transfer per received token");
+    for (const host::Transfer& transfer : transfers) {
+        const int64_t expected = transfer.quantity.symbol == tkb.get_symbol() ? out1 + 10000 - 50000 : out2;
+        Expect(transfer.to == ALICE && transfer.quantity.amount == expected,
+               "transfer of " + transfer.quantity.to_string());
+    }
+    Expect(transfers.size() == 2 && transfers[0].quantity.symbol != transfers[1].quantity.symbol
+           && transfers[0].quantity.symbol != tka.get_symbol() && transfers[1].quantity.symbol != tka.get_symbol(),
+           "transfers of TKB and TKC");
+
+    Expect(dex.GetDeposit(ALICE, tka).quantity.amount == 300000 - 100000 - in3 - fee3, "rest of the TKA deposit");
+    Expect(dex.GetDeposit(ALICE, tkb).quantity.amount == 0, "no TKB deposit");
+
+    const auto first_after = *dex.GetPair(PAIR_CODE);
+    Expect(first_after.pool1.quantity.amount == first.pool1.quantity.amount + in1 + in3
+           && first_after.pool2.quantity.amount == first.pool2.quantity.amount - out1 - 10000, "pools of TKA/TKB");
+
+    const int64_t share1 = GetRateOf(GetRateOf(in1, PAIR_FEE), FEE_COLLECTOR_RATE);
+    const int64_t share2 = GetRateOf(GetRateOf(in2, PAIR_FEE), FEE_COLLECTOR_RATE);
+    const int64_t share3 = GetRateOf(fee3, FEE_COLLECTOR_RATE);
+    Expect(dex.GetFee(FEE_COLLECTOR, tka).quantity.amount == fee_tka + share1 + share3, "TKA fees of swap.batch");
+    Expect(dex.GetFee(FEE_COLLECTOR, tkb).quantity.amount == fee_tkb + share2, "TKB fees of swap.batch");
+
+    const auto before = *dex.GetPair(PAIR_CODE);
+    const bool failed = !dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.SwapBatch(ALICE, {
+            { PAIR_TOKEN, Token("TKA", 50000), Token("TKB", 0), true },
+            { PAIR_TOKEN, Token("TKA", 200000), Token("TKB", 0), true },
+        });
+    }, &error);
+    Expect(failed, "swap.batch above the deposit fails");
+    const auto after = *dex.GetPair(PAIR_CODE);
+    Expect(after.pool1 == before.pool1 && after.pool2 == before.pool2, "pools after the failed swap.batch");
+}
+
+// swaps only accrue the collector share, claim.fees pays out everything accrued with one transfer per token
+void CheckClaimFees() {
+    host::Dex dex = Start();
+    const extended_symbol tokens[] = {
+        Token("TKA", 0).get_extended_symbol(),
+        Token("TKB", 0).get_extended_symbol(),
+        Token("TKC", 0).get_extended_symbol(),
+    };
+    // the add liquidity fees of the issuer are accrued too
+    int64_t accrued[size(tokens)] = {};
+    for (size_t i = 0; i < size(tokens); i++) {
+        accrued[i] = dex.GetFee(FEE_COLLECTOR, tokens[i]).quantity.amount;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        const extended_asset in { 100000 * (i + 1), tokens[i % 2] };
+        const extended_symbol out_token = tokens[(i + 1) % 2];
+        Contract::SwapResult result;
+        string error;
+        const bool swapped = dex.Deposit(in.contract, ALICE, in.quantity, "", &error)
+            && dex.Run({ ALICE }, [&](Contract& contract) {
+                result = contract.SwapIn(ALICE, PAIR_TOKEN, in, { 0, out_token }, {});
+            }, &error);
+        Expect(swapped, "swap.in " + error);
+        Expect(dex.GetTransfers().size() == 1, "no fee transfer of swap.in");
+
+        accrued[i % 2] += result.hop.fee_collector_share.quantity.amount;
+        Expect(result.hop.fee_collector_share.quantity.amount > 0
+               && dex.GetFee(FEE_COLLECTOR, tokens[i % 2]).quantity.amount == accrued[i % 2],
+               "accrued fee of " + in.quantity.to_string());
+    }
+
+    Expect(!dex.Run({ ALICE }, [&](Contract& contract) {
+        contract.ClaimFees(FEE_COLLECTOR);
+    }), "claim.fees authorized by another account fails");
+
+    string error;
+    const bool claimed = dex.Run({ FEE_COLLECTOR }, [&](Contract& contract) {
+        contract.ClaimFees(FEE_COLLECTOR);
+    }, &error);
+    Expect(claimed, "claim.fees " + error);
+
+    const vector<host::Transfer> transfers = dex.GetTransfers();
+    Expect(transfers.size() == size(tokens), "one claimed transfer per token");
+    for (const host::Transfer& transfer : transfers) {
+        const auto token_it = find_if(begin(tokens), end(tokens), [&](const extended_symbol& token) {
+            return token.get_symbol() == transfer.quantity.symbol;
+        });
+        Expect(token_it != end(tokens) && transfer.to == FEE_COLLECTOR
+               && transfer.quantity.amount == accrued[token_it - begin(tokens)],
+               "claimed " + transfer.quantity.to_string());
+    }
+    for (const extended_symbol& token : tokens) {
+        Expect(dex.GetFee(FEE_COLLECTOR, token).quantity.amount == 0, "no fee left after claim.fees");
+    }
+
+    const bool claimed_again = dex.Run({ FEE_COLLECTOR }, [&](Contract& contract) {
+        contract.ClaimFees(FEE_COLLECTOR);
+    }, &error);
+    Expect(!claimed_again && error.find("There is nothing to claim") != string::npos,
+           "second claim.fees fails: " + error);
+}
+
+// a transfer with a "swap:" memo is sold whole and the out is sent to the sender or the recipient of the memo,
+// nothing is written to the deposits
+void CheckMemoSwap() {
+    host::Dex dex = Start();
+
+    for (const name recipient : { ALICE, BOB }) {
+        const auto before = *dex.GetPair(PAIR_CODE);
+        const int64_t in = CalculateAmountWithoutFee(100000, PAIR_FEE);
+        const int64_t out = CalculateOutAmount(in, before.pool1.quantity.amount, before.pool2.quantity.amount);
+        const string memo = "swap:LPAB:" + to_string(out) + (recipient == ALICE ? "" : ":" + recipient.to_string());
+
+        string error;
+        const bool swapped = dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 100000).quantity, memo, &error);
+        Expect(swapped, "deposit with memo " + memo + " " + error);
+
+        const vector<host::Transfer> transfers = dex.GetTransfers();
+        Expect(transfers.size() == 1 && transfers[0].to == recipient
+               && transfers[0].quantity == Token("TKB", out).quantity, "out of the memo " + memo);
+
+        const auto after = *dex.GetPair(PAIR_CODE);
+        Expect(after.pool1.quantity.amount == before.pool1.quantity.amount + in
+               && after.pool2.quantity.amount == before.pool2.quantity.amount - out, "pools after the memo " + memo);
+        Expect(dex.GetDeposit(ALICE, Token("TKA", 0).get_extended_symbol()).quantity.amount == 0,
+               "no deposit of the memo " + memo);
+    }
+
+    const auto before = *dex.GetPair(PAIR_CODE);
+    const struct {
+        string memo;
+        string message;
+    } failed[] = {
+        { "swap:LPAB:1000000000", "received is less than expected" },
+        { "swap:LPAB", "invalid memo" },
+        { "swap:LPAB:0:carol:x", "invalid memo" },
+        { "swap:LPAB:1e3", "invalid amount" },
+        { "swap:LPXY:0", "pair token does not exist" },
+        { "swap:LPAB:0:carol", "recipient account does not exist" },
+    };
+    for (const auto& [memo, message] : failed) {
+        string error;
+        const bool swapped = dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 100000).quantity, memo, &error);
+        Expect(!swapped && error.find(message) != string::npos, "deposit with memo " + memo + " fails: " + error);
+    }
+
+    const auto after = *dex.GetPair(PAIR_CODE);
+    Expect(after.pool1 == before.pool1 && after.pool2 == before.pool2, "pools after the failed memos");
+    Expect(dex.GetDeposit(ALICE, Token("TKA", 0).get_extended_symbol()).quantity.amount == 0,
+           "no deposit of the failed memos");
+}
+
+// with keep_on_deposit nothing is transferred: the received tokens are added to the deposits, unused funds stay there
+// and the returned refunds are zero
+void CheckKeepOnDeposit() {
+    host::Dex dex = Start();
+    const extended_symbol tka = Token("TKA", 0).get_extended_symbol();
+    const extended_symbol tkb = Token("TKB", 0).get_extended_symbol();
+    binary_extension<bool> keep;
+    keep.emplace(true);
+
+    const auto deposit_of = [&](const extended_symbol& token) {
+        return dex.GetDeposit(ALICE, token).quantity.amount;
+    };
+    const auto run = [&](const string& what, const auto& action) {
+        string error;
+        const bool done = dex.Run({ ALICE }, action, &error);
+        Expect(done, what + " " + error);
+        Expect(dex.GetTransfers().empty(), "no transfers of " + what);
+    };
+
+    Expect(dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKA", 10000000).quantity)
+           && dex.Deposit(TOKEN_CONTRACT, ALICE, Token("TKB", 20000000).quantity), "deposits of alice");
+
+    Contract::SwapResult swap;
+    int64_t tka_before = deposit_of(tka);
+    int64_t tkb_before = deposit_of(tkb);
+    run("swap.in with keep_on_deposit", [&](Contract& contract) {
+        swap = contract.SwapIn(ALICE, PAIR_TOKEN, Token("TKA", 100000), Token("TKB", 0), keep);
+    });
+    Expect(swap.refund.quantity.amount == 0 && deposit_of(tka) == tka_before - 100000
+           && deposit_of(tkb) == tkb_before + swap.hop.out.quantity.amount, "deposits after swap.in");
+
+    tka_before = deposit_of(tka);
+    tkb_before = deposit_of(tkb);
+    run("swap with keep_on_deposit", [&](Contract& contract) {
+        swap = contract.Swap(ALICE, PAIR_TOKEN, Token("TKB", 100000), Token("TKA", 40000), keep);
+    });
+    Expect(swap.refund.quantity.amount == 0 && deposit_of(tka) == tka_before + 40000
+           && deposit_of(tkb) == tkb_before - (swap.hop.in + swap.hop.fee).quantity.amount, "deposits after swap");
+
+    Contract::LiquidityResult liquidity;
+    tka_before = deposit_of(tka);
+    tkb_before = deposit_of(tkb);
+    run("addliquidity with keep_on_deposit", [&](Contract& contract) {
+        liquidity = contract.AddLiquidity(ALICE, PAIR_TOKEN, Token("TKA", 5000000), Token("TKB", 15000000), keep);
+    });
+    Expect(liquidity.refund1.quantity.amount == 0 && liquidity.refund2.quantity.amount == 0, "addliquidity refunds");
+    Expect(deposit_of(tka) == tka_before - liquidity.asset1.quantity.amount
+           && deposit_of(tkb) == tkb_before - liquidity.asset2.quantity.amount, "deposits after addliquidity");
+    Expect(dex.GetBalance(ALICE, PAIR_TOKEN) == liquidity.liquidity, "liquidity of addliquidity");
+
+    tka_before = deposit_of(tka);
+    tkb_before = deposit_of(tkb);
+    const asset to_sell { liquidity.liquidity.amount / 2, PAIR_TOKEN };
+    run("remliquidity with keep_on_deposit", [&](Contract& contract) {
+        liquidity = contract.RemoveLiquidity(ALICE, to_sell, Token("TKA", 1), Token("TKB", 1), keep);
+    });
+    Expect(liquidity.asset1.quantity.amount > 0 && deposit_of(tka) == tka_before + liquidity.asset1.quantity.amount
+           && deposit_of(tkb) == tkb_before + liquidity.asset2.quantity.amount, "deposits after remliquidity");
+}
+
+}
+
+int main() {
+    CheckSwapPath();
+    CheckDuplicatePair();
+    CheckSwapBatch();
+    CheckMemoSwap();
+    CheckClaimFees();
+    CheckKeepOnDeposit();
+
+    if (failures > 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("swaps match the contract\n");
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <Fixture.hpp>
+#include <Util.hpp>
+
+#include <cstdio>
+#include <string>
+
+using namespace std;
+using namespace eosio;
+using namespace host::fixture;
+
+// Runs addliq.zap of small to large amounts, up to several times the pool, on pairs whose raw pools have drifted
+// from the pools, and checks that the refunded rest of both tokens is only rounding. Exits with 1 on a larger rest.
+namespace {
+
+const name USER = "alice"_n;
+
+const uint32_t DRIFT_SWAPS = 20;
+
+// liquidity added after create.pair, in initial pools; the pools may then go down to a quarter, less than the
+// swap of the largest zap leaves
+const int64_t ADDED_POOLS = 3;
+
+// rest allowed on top of one unit of liquidity and the rounding of the amounts, of 10^6 of the added amount
+const int64_t REST_PPM = 10;
+
+bool Deposit(host::Dex& dex, const name from, const extended_asset& quantity) {
+    return dex.Deposit(quantity.contract, from, quantity.quantity);
+}
+
+// swaps of 1% of the pool in both directions, the fees make the raw pools differ from the pools
+void Drift(host::Dex& dex) {
+    for (uint32_t i = 0; i < DRIFT_SWAPS; i++) {
+        const auto record = *dex.GetPair(PAIR_CODE);
+        const extended_asset& pool_in = i % 2 == 0 ? record.pool1 : record.pool2;
+        const extended_asset& pool_out = i % 2 == 0 ? record.pool2 : record.pool1;
+        const extended_asset in { pool_in.quantity / 100, pool_in.contract };
+
+        Deposit(dex, USER, in);
+        dex.Run({ USER }, [&](Contract& contract) {
+            contract.SwapIn(USER, PAIR_TOKEN, in, { 0, pool_out.get_extended_symbol() }, {});
+        });
+    }
+}
+
+void CheckRest(const extended_asset& rest, const int64_t added, const int64_t raw_pool, const int64_t supply,
+               const string& what) {
+    const int64_t allowed = added / 1000000 * REST_PPM + raw_pool / supply + 2;
+    if (rest.quantity.amount > allowed) {
+        printf("failed: %s, rest %s of %lld added, %lld allowed\n", what.c_str(), rest.quantity.to_string().c_str(),
+               (long long) added, (long long) allowed);
+        failures++;
+    }
+}
+
+// zap of "per_mille" of the pool of the token of "first"
+void CheckZap(const int64_t amount1, const int64_t amount2, const bool first, const int64_t per_mille) {
+    host::Chain::Get().Reset();
+    host::Dex dex { SELF };
+    for (const name account : { ISSUER, FEE_COLLECTOR, USER }) {
+        host::Chain::Get().AddAccount(account.value);
+    }
+
+    const string what = "pools " + to_string(amount1) + "/" + to_string(amount2) + ", " + to_string(per_mille)
+        + "/1000 of pool" + (first ? "1" : "2");
+    if (!CreatePair(dex, Token("TKA", amount1), Token("TKB", amount2))
+        || !AddLiquidity(dex, ISSUER, Token("TKA", amount1 * ADDED_POOLS), Token("TKB", amount2 * ADDED_POOLS))) {
+        printf("failed: create.pair or addliquidity, %s\n", what.c_str());
+        failures++;
+        return;
+    }
+    Drift(dex);
+
+    const auto before = *dex.GetPair(PAIR_CODE);
+    const extended_asset& pool = first ? before.pool1 : before.pool2;
+    const extended_asset in { pool.quantity.amount / 1000 * per_mille, pool.get_extended_symbol() };
+
+    Contract::LiquidityResult result;
+    string error;
+    Deposit(dex, USER, in);
+    if (!dex.Run({ USER }, [&](Contract& contract) {
+        result = contract.AddLiquiditySingle(USER, PAIR_TOKEN, in, asset { 0, PAIR_TOKEN }, {});
+    }, &error)) {
+        printf("failed: addliq.zap, %s: %s\n", what.c_str(), error.c_str());
+        failures++;
+        return;
+    }
+
+    // the rest of the swapped out is measured against the value of "in" in the out token
+    const auto after = *dex.GetPair(PAIR_CODE);
+    const int64_t value1 = first ? in.quantity.amount
+        : CalculateOutAmount(in.quantity.amount, before.pool2.quantity.amount, before.pool1.quantity.amount);
+    const int64_t value2 = first
+        ? CalculateOutAmount(in.quantity.amount, before.pool1.quantity.amount, before.pool2.quantity.amount)
+        : in.quantity.amount;
+    CheckRest(result.refund1, value1, after.raw_pool1_amount, after.supply.amount, what + ", pool1");
+    CheckRest(result.refund2, value2, after.raw_pool2_amount, after.supply.amount, what + ", pool2");
+}
+
+}
+
+int main() {
+    // the add liquidity fee is 10^-6 of the added amounts and at least a unit, so the smallest zap has to add
+    // 10^6 units of both tokens
+    const int64_t pools[][2] = {
+        { 1000000000, 2000000000 },
+        { 1000000000000, 3000000000000 },
+        { INIT_MAX - 1, 1000000000 },
+    };
+    const int64_t per_milles[] = { 1, 100, 1000, 5000 };
+
+    for (const auto& [amount1, amount2] : pools) {
+        for (const int64_t per_mille : per_milles) {
+            CheckZap(amount1, amount2, true, per_mille);
+            CheckZap(amount1, amount2, false, per_mille);
+        }
+    }
+
+    if (failures > 0) {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("zap rests are within rounding\n");
+    return 0;
+}